@@ -0,0 +1,15 @@
+public class Bench {
+    public int value = 42;
+
+    public static int staticValue() {
+        return 42;
+    }
+
+    public int value() {
+        return value;
+    }
+
+    public String string() {
+        return "The quick brown fox jumps over the lazy dog";
+    }
+}
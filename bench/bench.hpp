@@ -0,0 +1,226 @@
+#pragma once
+
+// A minimal benchmark harness: each benchmark is run in a number of samples, each a batch of
+// iterations, and the per-iteration time of each sample is recorded. Results are reported as
+// percentiles over samples, in JSON or CSV.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bench
+   {
+    // Prevents the compiler from optimizing away the computation of `value`.
+    template < class T >
+    inline void DoNotOptimize(const T& value)
+       {
+        asm volatile("" : : "r,m"(value) : "memory");
+       }
+
+    struct Options
+       {
+        std::size_t samples = 100;
+        std::size_t iterations = 1000;
+        std::string format = "json";
+        std::string filter;
+       };
+
+    struct Result
+       {
+        std::string group;
+        std::string variant;
+        std::size_t samples;
+        std::size_t iterations;
+        double min;
+        double p50;
+        double p90;
+        double p99;
+        double mean;
+       };
+
+    class Runner
+       {
+        private:
+            Options options;
+            std::vector<Result> results;
+
+            static double Percentile(const std::vector<double>& sorted, double p)
+               {
+                const std::size_t index = static_cast<std::size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+                return sorted[index];
+               }
+
+            void Record(const std::string& group, const std::string& variant, std::vector<double>& perCall)
+               {
+                std::sort(perCall.begin(), perCall.end());
+
+                double total = 0;
+                for (double t : perCall)
+                    total += t;
+
+                results.push_back({ group, variant, options.samples, options.iterations,
+                    perCall.front(),
+                    Percentile(perCall, 0.50),
+                    Percentile(perCall, 0.90),
+                    Percentile(perCall, 0.99),
+                    total / static_cast<double>(perCall.size()) });
+               }
+
+        public:
+            explicit Runner(Options o)
+               : options(std::move(o))
+               {}
+
+            // Runs `f` (which is passed the iteration index) and records the time per call, in
+            // nanoseconds. `group` names the operation and `variant` the implementation -- e.g.
+            // "raw" or "jni.hpp" -- so that variants of one group can be compared.
+            template < class F >
+            void Run(const std::string& group, const std::string& variant, F&& f)
+               {
+                if (!options.filter.empty() && group.find(options.filter) == std::string::npos)
+                    return;
+
+                for (std::size_t i = 0; i < options.iterations; ++i)
+                    f(i);
+
+                std::vector<double> perCall;
+                perCall.reserve(options.samples);
+
+                for (std::size_t s = 0; s < options.samples; ++s)
+                   {
+                    const auto start = std::chrono::steady_clock::now();
+                    for (std::size_t i = 0; i < options.iterations; ++i)
+                        f(i);
+                    const auto end = std::chrono::steady_clock::now();
+
+                    const std::chrono::duration<double, std::nano> elapsed = end - start;
+                    perCall.push_back(elapsed.count() / static_cast<double>(options.iterations));
+                   }
+
+                Record(group, variant, perCall);
+               }
+
+            // Runs `f` on `threads` threads at once, to measure contention. Each thread first calls
+            // `makeWorker()`, untimed, and then calls the worker it returns (which is passed the
+            // iteration index) in each sample, all threads starting together. Records the time per
+            // call as seen by each thread -- the sample's wall time divided by `iterations` -- so that
+            // with no contention, the result matches a single-threaded run.
+            template < class MakeWorker >
+            void RunParallel(const std::string& group, const std::string& variant, std::size_t threads, MakeWorker makeWorker)
+               {
+                if (!options.filter.empty() && group.find(options.filter) == std::string::npos)
+                    return;
+
+                std::atomic<std::size_t> ready { 0 };
+                std::atomic<std::size_t> generation { 0 };
+                std::atomic<std::size_t> done { 0 };
+                const std::size_t generations = options.samples + 1; // The first is a warmup.
+
+                std::vector<std::thread> pool;
+                for (std::size_t t = 0; t < threads; ++t)
+                   {
+                    pool.emplace_back([&]
+                       {
+                        auto worker = makeWorker();
+                        ++ready;
+                        for (std::size_t g = 1; g <= generations; ++g)
+                           {
+                            while (generation.load() != g)
+                                std::this_thread::yield();
+                            for (std::size_t i = 0; i < options.iterations; ++i)
+                                worker(i);
+                            ++done;
+                           }
+                       });
+                   }
+
+                while (ready.load() != threads)
+                    std::this_thread::yield();
+
+                std::vector<double> perCall;
+                perCall.reserve(options.samples);
+
+                for (std::size_t g = 1; g <= generations; ++g)
+                   {
+                    done.store(0);
+                    const auto start = std::chrono::steady_clock::now();
+                    generation.store(g);
+                    while (done.load() != threads)
+                        std::this_thread::yield();
+                    const auto end = std::chrono::steady_clock::now();
+
+                    const std::chrono::duration<double, std::nano> elapsed = end - start;
+                    if (g > 1)
+                        perCall.push_back(elapsed.count() / static_cast<double>(options.iterations));
+                   }
+
+                for (std::thread& thread : pool)
+                    thread.join();
+
+                Record(group, variant, perCall);
+               }
+
+            void Report(std::ostream& out) const
+               {
+                out << std::fixed << std::setprecision(2);
+
+                if (options.format == "csv")
+                   {
+                    out << "group,variant,samples,iterations,min_ns,p50_ns,p90_ns,p99_ns,mean_ns\n";
+                    for (const Result& r : results)
+                       {
+                        out << r.group << ',' << r.variant << ',' << r.samples << ',' << r.iterations << ','
+                            << r.min << ',' << r.p50 << ',' << r.p90 << ',' << r.p99 << ',' << r.mean << '\n';
+                       }
+                    return;
+                   }
+
+                out << "[\n";
+                for (std::size_t i = 0; i < results.size(); ++i)
+                   {
+                    const Result& r = results[i];
+                    out << "  { \"group\": \"" << r.group << "\", \"variant\": \"" << r.variant << "\""
+                        << ", \"samples\": " << r.samples << ", \"iterations\": " << r.iterations
+                        << ", \"min_ns\": " << r.min << ", \"p50_ns\": " << r.p50
+                        << ", \"p90_ns\": " << r.p90 << ", \"p99_ns\": " << r.p99
+                        << ", \"mean_ns\": " << r.mean << " }" << (i + 1 < results.size() ? ",\n" : "\n");
+                   }
+                out << "]\n";
+               }
+       };
+
+    // Parses `--samples=N`, `--iterations=N`, `--format=json|csv`, and `--filter=substring`.
+    // Other arguments are returned in `rest`.
+    inline Options ParseOptions(int argc, char** argv, std::vector<std::string>& rest)
+       {
+        Options options;
+        for (int i = 1; i < argc; ++i)
+           {
+            const std::string arg = argv[i];
+            auto value = [&] (const char* prefix) -> const char*
+               {
+                return arg.compare(0, std::strlen(prefix), prefix) == 0 ? argv[i] + std::strlen(prefix) : nullptr;
+               };
+
+            if (const char* v = value("--samples="))
+                options.samples = std::max<std::size_t>(std::strtoul(v, nullptr, 10), 1);
+            else if (const char* v = value("--iterations="))
+                options.iterations = std::max<std::size_t>(std::strtoul(v, nullptr, 10), 1);
+            else if (const char* v = value("--format="))
+                options.format = v;
+            else if (const char* v = value("--filter="))
+                options.filter = v;
+            else
+                rest.push_back(arg);
+           }
+        return options;
+       }
+   }
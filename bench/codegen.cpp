@@ -0,0 +1,125 @@
+// Pairs of functions, each performing one operation through the raw JNIEnv and through jni.hpp
+// with the same semantics -- including jni.hpp's exception check, and its range check on `jsize`
+// arguments, which jni.hpp represents as std::size_t. misc/codegen-check.sh compiles this file at
+// -O2 and checks that the fast path of each `jnihpp_` function has no more instructions than that
+// of the corresponding `raw_` function.
+
+#include <jni/jni.hpp>
+
+#include <limits>
+#include <stdexcept>
+
+namespace
+   {
+    inline void RawCheck(JNIEnv* env)
+       {
+        if (env->ExceptionCheck())
+           {
+            env->ExceptionDescribe();
+            throw jni::PendingJavaException();
+           }
+       }
+
+    inline jsize RawSize(std::size_t s)
+       {
+        if (s > static_cast<std::size_t>(std::numeric_limits<jsize>::max()))
+            throw std::range_error("jsize > max");
+        return static_cast<jsize>(s);
+       }
+   }
+
+extern "C"
+   {
+    // Field access
+
+    jint raw_get_int_field(JNIEnv* env, jobject obj, jfieldID field)
+       {
+        jint result = env->GetIntField(obj, field);
+        RawCheck(env);
+        return result;
+       }
+
+    jint jnihpp_get_int_field(jni::JNIEnv* env, jni::jobject* obj, jni::jfieldID* field)
+       {
+        return jni::GetField<jni::jint>(*env, obj, *field);
+       }
+
+    void raw_set_int_field(JNIEnv* env, jobject obj, jfieldID field, jint value)
+       {
+        env->SetIntField(obj, field, value);
+        RawCheck(env);
+       }
+
+    void jnihpp_set_int_field(jni::JNIEnv* env, jni::jobject* obj, jni::jfieldID* field, jni::jint value)
+       {
+        jni::SetField<jni::jint>(*env, obj, *field, value);
+       }
+
+    // Method calls
+
+    jint raw_call_int_method(JNIEnv* env, jobject obj, jmethodID method, jint arg)
+       {
+        jint result = env->CallIntMethod(obj, method, arg);
+        RawCheck(env);
+        return result;
+       }
+
+    jint jnihpp_call_int_method(jni::JNIEnv* env, jni::jobject* obj, jni::jmethodID* method, jni::jint arg)
+       {
+        return jni::CallMethod<jni::jint>(*env, obj, *method, arg);
+       }
+
+    // Array regions
+
+    void raw_get_int_array_region(JNIEnv* env, jintArray array, std::size_t start, std::size_t len, jint* buf)
+       {
+        env->GetIntArrayRegion(array, RawSize(start), RawSize(len), buf);
+        RawCheck(env);
+       }
+
+    void jnihpp_get_int_array_region(jni::JNIEnv* env, jni::jarray<jni::jint>* array, jni::jsize start, jni::jsize len, jni::jint* buf)
+       {
+        jni::GetArrayRegion(*env, *array, start, len, buf);
+       }
+
+    // Local references
+
+    void raw_local_ref(JNIEnv* env, jobject obj)
+       {
+        jobject ref = env->NewLocalRef(obj);
+        RawCheck(env);
+        if (obj && !ref)
+            throw std::bad_alloc();
+        if (ref)
+            env->DeleteLocalRef(ref);
+       }
+
+    void jnihpp_local_ref(jni::JNIEnv* env, jni::jobject* obj)
+       {
+        jni::NewLocalRef(*env, obj);
+       }
+
+    // Tagging
+
+    jobject raw_untag(jobject obj)
+       {
+        return obj;
+       }
+
+    jobject jnihpp_untag(jobject obj)
+       {
+        return jni::Unwrap(jni::Untag(jni::Object<>(jni::Wrap<jni::jobject*>(obj))));
+       }
+
+    // Exception checks
+
+    void raw_check_java_exception(JNIEnv* env)
+       {
+        RawCheck(env);
+       }
+
+    void jnihpp_check_java_exception(jni::JNIEnv* env)
+       {
+        jni::CheckJavaException(*env);
+       }
+   }
@@ -0,0 +1,257 @@
+// Measures the overhead of the jni.hpp wrappers relative to raw JNI, in a JVM created in-process
+// with JNI_CreateJavaVM. Each group is measured once through the raw JNIEnv function table and
+// once through jni.hpp. Run with `make bench`; see bench.hpp for options.
+
+#include "bench.hpp"
+
+#include <jni/jni.hpp>
+#include <jni/global_ref_pool.hpp>
+
+#include <array>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+   {
+    struct BenchTag { static constexpr auto Name() { return "Bench"; } };
+
+    // JNI_CreateJavaVM takes `void**` in OpenJDK's jni.h, and `JNIEnv**` in Android's.
+    struct EnvOut
+       {
+        JNIEnv** env;
+        operator JNIEnv**() const { return env; }
+        operator void**() const { return reinterpret_cast<void**>(env); }
+       };
+
+    void RunBenchmarks(bench::Runner& runner, JNIEnv& raw)
+       {
+        jni::JNIEnv& env = raw;
+
+        auto& klass = jni::Class<BenchTag>::Singleton(env);
+        auto constructor = klass.GetConstructor<>(env);
+        auto instance = klass.New(env, constructor);
+
+        auto staticMethod = klass.GetStaticMethod<jni::jint ()>(env, "staticValue");
+        auto method = klass.GetMethod<jni::jint ()>(env, "value");
+        auto field = klass.GetField<jni::jint>(env, "value");
+        auto stringMethod = klass.GetMethod<jni::String ()>(env, "string");
+
+        ::jclass rawClass = jni::Unwrap(klass.get());
+        ::jobject rawInstance = jni::Unwrap(instance.get());
+        ::jmethodID rawStaticMethod = raw.GetStaticMethodID(rawClass, "staticValue", "()I");
+        ::jmethodID rawMethod = raw.GetMethodID(rawClass, "value", "()I");
+        ::jfieldID rawField = raw.GetFieldID(rawClass, "value", "I");
+
+        runner.Run("static_method_call", "raw", [&] (std::size_t)
+           {
+            bench::DoNotOptimize(raw.CallStaticIntMethod(rawClass, rawStaticMethod));
+            if (raw.ExceptionCheck()) throw jni::PendingJavaException();
+           });
+        runner.Run("static_method_call", "jni.hpp", [&] (std::size_t)
+           {
+            bench::DoNotOptimize(klass.Call(env, staticMethod));
+           });
+
+        runner.Run("method_call", "raw", [&] (std::size_t)
+           {
+            bench::DoNotOptimize(raw.CallIntMethod(rawInstance, rawMethod));
+            if (raw.ExceptionCheck()) throw jni::PendingJavaException();
+           });
+        runner.Run("method_call", "jni.hpp", [&] (std::size_t)
+           {
+            bench::DoNotOptimize(instance.Call(env, method));
+           });
+
+        runner.Run("field_get", "raw", [&] (std::size_t)
+           {
+            bench::DoNotOptimize(raw.GetIntField(rawInstance, rawField));
+            if (raw.ExceptionCheck()) throw jni::PendingJavaException();
+           });
+        runner.Run("field_get", "jni.hpp", [&] (std::size_t)
+           {
+            bench::DoNotOptimize(instance.Get(env, field));
+           });
+
+        runner.Run("field_set", "raw", [&] (std::size_t i)
+           {
+            raw.SetIntField(rawInstance, rawField, static_cast<::jint>(i));
+            if (raw.ExceptionCheck()) throw jni::PendingJavaException();
+           });
+        runner.Run("field_set", "jni.hpp", [&] (std::size_t i)
+           {
+            instance.Set(env, field, static_cast<jni::jint>(i));
+           });
+
+        auto array = jni::Array<jni::jint>::New(env, 1024);
+        ::jintArray rawArray = jni::Unwrap(array.get());
+        std::array<jni::jint, 1024> buffer {};
+
+        runner.Run("array_region_1024", "raw", [&] (std::size_t)
+           {
+            raw.GetIntArrayRegion(rawArray, 0, 1024, buffer.data());
+            if (raw.ExceptionCheck()) throw jni::PendingJavaException();
+            bench::DoNotOptimize(buffer);
+           });
+        runner.Run("array_region_1024", "jni.hpp", [&] (std::size_t)
+           {
+            array.GetRegion(env, 0, buffer);
+            bench::DoNotOptimize(buffer);
+           });
+
+        runner.Run("array_to_vector_1024", "raw", [&] (std::size_t)
+           {
+            std::vector<jni::jint> result(static_cast<std::size_t>(raw.GetArrayLength(rawArray)));
+            raw.GetIntArrayRegion(rawArray, 0, static_cast<::jsize>(result.size()), result.data());
+            if (raw.ExceptionCheck()) throw jni::PendingJavaException();
+            bench::DoNotOptimize(result.data());
+           });
+        runner.Run("array_to_vector_1024", "jni.hpp", [&] (std::size_t)
+           {
+            bench::DoNotOptimize(jni::Make<std::vector<jni::jint>>(env, array).data());
+           });
+
+        const std::u16string text = u"The quick brown fox jumps over the lazy dog";
+        auto string = instance.Call(env, stringMethod);
+        ::jstring rawString = jni::Unwrap(string.get());
+
+        runner.Run("string_to_native", "raw", [&] (std::size_t)
+           {
+            std::u16string result(static_cast<std::size_t>(raw.GetStringLength(rawString)), char16_t());
+            raw.GetStringRegion(rawString, 0, static_cast<::jsize>(result.size()), reinterpret_cast<::jchar*>(&result[0]));
+            if (raw.ExceptionCheck()) throw jni::PendingJavaException();
+            bench::DoNotOptimize(result.data());
+           });
+        runner.Run("string_to_native", "jni.hpp", [&] (std::size_t)
+           {
+            bench::DoNotOptimize(jni::Make<std::u16string>(env, string).data());
+           });
+
+        runner.Run("string_to_java", "raw", [&] (std::size_t)
+           {
+            ::jstring result = raw.NewString(reinterpret_cast<const ::jchar*>(text.data()), static_cast<::jsize>(text.size()));
+            if (raw.ExceptionCheck()) throw jni::PendingJavaException();
+            raw.DeleteLocalRef(result);
+           });
+        runner.Run("string_to_java", "jni.hpp", [&] (std::size_t)
+           {
+            bench::DoNotOptimize(jni::Make<jni::String>(env, text).get());
+           });
+
+        ::jclass rawIntegerClass = raw.FindClass("java/lang/Integer");
+        ::jmethodID rawValueOf = raw.GetStaticMethodID(rawIntegerClass, "valueOf", "(I)Ljava/lang/Integer;");
+
+        runner.Run("box_small", "raw", [&] (std::size_t i)
+           {
+            ::jobject boxed = raw.CallStaticObjectMethod(rawIntegerClass, rawValueOf, static_cast<::jint>(i % 128));
+            if (raw.ExceptionCheck()) throw jni::PendingJavaException();
+            raw.DeleteLocalRef(boxed);
+           });
+        runner.Run("box_small", "jni.hpp", [&] (std::size_t i)
+           {
+            bench::DoNotOptimize(jni::Box(env, static_cast<jni::jint>(i % 128)).get());
+           });
+
+        runner.Run("box_large", "raw", [&] (std::size_t i)
+           {
+            ::jobject boxed = raw.CallStaticObjectMethod(rawIntegerClass, rawValueOf, static_cast<::jint>(i + 1000));
+            if (raw.ExceptionCheck()) throw jni::PendingJavaException();
+            raw.DeleteLocalRef(boxed);
+           });
+        runner.Run("box_large", "jni.hpp", [&] (std::size_t i)
+           {
+            bench::DoNotOptimize(jni::Box(env, static_cast<jni::jint>(i + 1000)).get());
+           });
+
+        runner.Run("local_ref", "raw", [&] (std::size_t)
+           {
+            ::jobject ref = raw.NewLocalRef(rawInstance);
+            raw.DeleteLocalRef(ref);
+           });
+        runner.Run("local_ref", "jni.hpp", [&] (std::size_t)
+           {
+            bench::DoNotOptimize(jni::NewLocalRef(env, instance.get()).get());
+           });
+
+        runner.Run("global_ref", "raw", [&] (std::size_t)
+           {
+            ::jobject ref = raw.NewGlobalRef(rawInstance);
+            raw.DeleteGlobalRef(ref);
+           });
+        runner.Run("global_ref", "jni.hpp", [&] (std::size_t)
+           {
+            bench::DoNotOptimize(jni::NewGlobal(env, instance).get());
+           });
+
+        // Global reference churn with many threads, where NewGlobalRef and DeleteGlobalRef contend
+        // for a JVM-wide lock, compared with GlobalRefPool.
+        constexpr std::size_t contendingThreads = 32;
+        JavaVM& vm = jni::GetJavaVM(env);
+        auto shared = jni::NewGlobal(env, instance);
+        ::jobject rawShared = jni::Unwrap(shared.get());
+        jni::GlobalRefPool<jni::Object<BenchTag>> pool;
+
+        runner.RunParallel("global_ref_32_threads", "raw", contendingThreads, [&]
+           {
+            return [attached = jni::AttachCurrentThread(vm), rawShared] (std::size_t)
+               {
+                ::jobject ref = attached->NewGlobalRef(rawShared);
+                attached->DeleteGlobalRef(ref);
+               };
+           });
+        runner.RunParallel("global_ref_32_threads", "jni.hpp", contendingThreads, [&]
+           {
+            return [attached = jni::AttachCurrentThread(vm), &shared] (std::size_t)
+               {
+                bench::DoNotOptimize(jni::NewGlobal(*attached, shared).get());
+               };
+           });
+        runner.RunParallel("global_ref_32_threads", "pool", contendingThreads, [&]
+           {
+            return [attached = jni::AttachCurrentThread(vm), &shared, &pool] (std::size_t)
+               {
+                bench::DoNotOptimize(pool.Add(*attached, shared));
+               };
+           });
+
+        raw.DeleteLocalRef(rawIntegerClass);
+       }
+   }
+
+int main(int argc, char** argv)
+   {
+    std::vector<std::string> jvmArguments;
+    bench::Runner runner(bench::ParseOptions(argc, argv, jvmArguments));
+
+    std::vector<JavaVMOption> options;
+    for (std::string& argument : jvmArguments)
+        options.push_back({ &argument[0], nullptr });
+
+    JavaVMInitArgs args;
+    args.version = JNI_VERSION_1_6;
+    args.nOptions = static_cast<::jint>(options.size());
+    args.options = options.data();
+    args.ignoreUnrecognized = JNI_FALSE;
+
+    JavaVM* vm = nullptr;
+    JNIEnv* env = nullptr;
+    if (JNI_CreateJavaVM(&vm, EnvOut { &env }, &args) != JNI_OK)
+       {
+        std::cerr << "JNI_CreateJavaVM failed" << std::endl;
+        return 1;
+       }
+
+    try
+       {
+        RunBenchmarks(runner, *env);
+       }
+    catch (const jni::PendingJavaException&)
+       {
+        env->ExceptionDescribe();
+        return 1;
+       }
+
+    runner.Report(std::cout);
+    vm->DestroyJavaVM();
+    return 0;
+   }
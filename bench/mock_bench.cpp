@@ -0,0 +1,139 @@
+// Measures the pure C++ overhead of the jni.hpp wrappers, by running them against the mock JNIEnv
+// from test/test.hpp, with JNI functions stubbed to do nothing. Each group is measured once through
+// the raw function table and once through jni.hpp, so that the difference isolates the cost of
+// wrapping from the cost of the JVM. Run with `make bench-mock`; see bench.hpp for options.
+
+#include "bench.hpp"
+#include "../test/test.hpp"
+
+#include <jni/jni.hpp>
+
+#include <iostream>
+
+namespace
+   {
+    struct MockTag { static constexpr auto Name() { return "Mock"; } };
+
+    Testable<jni::jclass> classValue;
+    Testable<jni::jobject> objectValue;
+    Testable<jni::jfieldID> fieldValue;
+    Testable<jni::jarray<jni::jint>> arrayValue;
+
+    JNIInvokeInterface vmFunctions {};
+    JavaVM vm { &vmFunctions };
+
+    void StubFunctions(TestEnv& env)
+       {
+        vmFunctions.GetEnv = [] (JavaVM*, void**, jint) -> jint { return JNI_EDETACHED; };
+
+        env.fns->GetJavaVM = [] (JNIEnv*, JavaVM** result) -> jint { *result = &vm; return JNI_OK; };
+        env.fns->ExceptionDescribe = [] (JNIEnv*) {};
+        env.fns->FindClass = [] (JNIEnv*, const char*) -> jclass { return jni::Unwrap(classValue.Ptr()); };
+        env.fns->NewGlobalRef = [] (JNIEnv*, jobject obj) -> jobject { return obj; };
+        env.fns->DeleteGlobalRef = [] (JNIEnv*, jobject) {};
+        env.fns->NewLocalRef = [] (JNIEnv*, jobject obj) -> jobject { return obj; };
+        env.fns->DeleteLocalRef = [] (JNIEnv*, jobject) {};
+        env.fns->GetFieldID = [] (JNIEnv*, jclass, const char*, const char*) -> jfieldID { return jni::Unwrap(fieldValue.Ptr()); };
+        env.fns->GetIntField = [] (JNIEnv*, jobject, jfieldID) -> jint { return 42; };
+        env.fns->SetIntField = [] (JNIEnv*, jobject, jfieldID, jint) {};
+        env.fns->GetArrayLength = [] (JNIEnv*, jarray) -> jsize { return 16; };
+        env.fns->GetIntArrayRegion = [] (JNIEnv*, jintArray, jsize, jsize, jint*) {};
+       }
+
+    void RunBenchmarks(bench::Runner& runner, TestEnv& env)
+       {
+        JNIEnv& raw = env;
+
+        ::jobject rawObject = jni::Unwrap(objectValue.Ptr());
+        ::jfieldID rawField = jni::Unwrap(fieldValue.Ptr());
+
+        runner.Run("check_java_exception", "raw", [&] (std::size_t)
+           {
+            if (raw.ExceptionCheck()) throw jni::PendingJavaException();
+           });
+        runner.Run("check_java_exception", "jni.hpp", [&] (std::size_t)
+           {
+            jni::CheckJavaException(env);
+           });
+
+        runner.Run("wrap_unwrap", "raw", [&] (std::size_t i)
+           {
+            bench::DoNotOptimize(static_cast<::jsize>(i & 0xFF));
+           });
+        runner.Run("wrap_unwrap", "jni.hpp", [&] (std::size_t i)
+           {
+            bench::DoNotOptimize(jni::Unwrap(jni::Wrap<jni::jsize>(static_cast<::jsize>(i & 0xFF))));
+           });
+
+        runner.Run("tag_untag", "raw", [&] (std::size_t)
+           {
+            bench::DoNotOptimize(rawObject);
+           });
+        runner.Run("tag_untag", "jni.hpp", [&] (std::size_t)
+           {
+            bench::DoNotOptimize(jni::Untag(jni::Tag<jni::Object<>>(env, objectValue.Ref())));
+           });
+
+        runner.Run("get_field_low_level", "raw", [&] (std::size_t)
+           {
+            bench::DoNotOptimize(raw.GetIntField(rawObject, rawField));
+            if (raw.ExceptionCheck()) throw jni::PendingJavaException();
+           });
+        runner.Run("get_field_low_level", "jni.hpp", [&] (std::size_t)
+           {
+            bench::DoNotOptimize(jni::GetField<jni::jint>(env, objectValue.Ptr(), fieldValue.Ref()));
+           });
+
+        auto& klass = jni::Class<MockTag>::Singleton(env);
+        auto field = klass.GetField<jni::jint>(env, "value");
+        const jni::Object<MockTag> object(objectValue.Ptr());
+
+        runner.Run("get_field_high_level", "raw", [&] (std::size_t)
+           {
+            bench::DoNotOptimize(raw.GetIntField(rawObject, rawField));
+            if (raw.ExceptionCheck()) throw jni::PendingJavaException();
+           });
+        runner.Run("get_field_high_level", "jni.hpp", [&] (std::size_t)
+           {
+            bench::DoNotOptimize(object.Get(env, field));
+           });
+
+        runner.Run("local_lifecycle", "raw", [&] (std::size_t)
+           {
+            ::jobject ref = raw.NewLocalRef(rawObject);
+            if (raw.ExceptionCheck()) throw jni::PendingJavaException();
+            raw.DeleteLocalRef(ref);
+           });
+        runner.Run("local_lifecycle", "jni.hpp", [&] (std::size_t)
+           {
+            bench::DoNotOptimize(jni::NewLocal(env, object).get());
+           });
+
+        runner.Run("array_region_16", "raw", [&] (std::size_t)
+           {
+            ::jint buffer[16];
+            raw.GetIntArrayRegion(jni::Unwrap(arrayValue.Ptr()), 0, 16, buffer);
+            if (raw.ExceptionCheck()) throw jni::PendingJavaException();
+            bench::DoNotOptimize(buffer);
+           });
+        runner.Run("array_region_16", "jni.hpp", [&] (std::size_t)
+           {
+            jni::jint buffer[16];
+            jni::GetArrayRegion(env, arrayValue.Ref(), 0, buffer);
+            bench::DoNotOptimize(buffer);
+           });
+       }
+   }
+
+int main(int argc, char** argv)
+   {
+    std::vector<std::string> unused;
+    bench::Runner runner(bench::ParseOptions(argc, argv, unused));
+
+    TestEnv env;
+    StubFunctions(env);
+    RunBenchmarks(runner, env);
+
+    runner.Report(std::cout);
+    return 0;
+   }
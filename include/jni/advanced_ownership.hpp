@@ -2,6 +2,10 @@
 
 #include <jni/functions.hpp>
 
+#include <atomic>
+#include <cstddef>
+#include <new>
+
 namespace jni
    {
     // A deleter that gets the JNIEnv via GetEnv, rather than storing the value passed to the constructor.
@@ -28,7 +32,10 @@ namespace jni
                 if (p)
                    {
                     assert(vm);
-                    (GetEnv(*vm).*DeleteRef)(Unwrap(p));
+                    ReferenceTracking::Deleted(ReferenceKindOf<DeleteRef>::value, p);
+                    JNIEnv& env = GetEnv(*vm);
+                    Instrumentation::Call call(env, JNIFunctionOf<DeleteRef>::value);
+                    (env.*DeleteRef)(Unwrap(p));
                    }
                }
        };
@@ -57,15 +64,182 @@ namespace jni
                 if (p)
                    {
                     assert(vm);
+                    ReferenceTracking::Deleted(ReferenceKindOf<DeleteRef>::value, p);
                     JNIEnv* env = nullptr;
                     jint err = vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_1);
                     if (err == JNI_OK)
                        {
+                        Instrumentation::Call call(*env, JNIFunctionOf<DeleteRef>::value);
                         (env->*DeleteRef)(Unwrap(p));
                        }
                     else if (err == JNI_EDETACHED)
                        {
-                        ((*AttachCurrentThread(*vm)).*DeleteRef)(Unwrap(p));
+                        UniqueEnv attached = AttachCurrentThread(*vm);
+                        Instrumentation::Call call(*attached, JNIFunctionOf<DeleteRef>::value);
+                        ((*attached).*DeleteRef)(Unwrap(p));
+                       }
+                    else
+                       {
+                        CheckErrorCode(err);
+                       }
+                   }
+               }
+       };
+
+    // A process-wide queue of references whose deletion was deferred by EnvDeferringDeleter because
+    // the deleting thread had no JVM attachment. Deferring is a lock-free push; the queue is drained
+    // by the next EnvDeferringDeleter deletion on an attached thread, or by an explicit Flush, which
+    // deletes the whole batch with one JNIEnv.
+    //
+    // At shutdown, call Shutdown from an attached thread before the JVM is destroyed. It deletes the
+    // pending references, after which deferred deletions are ignored, as with EnvIgnoringDeleter.
+    //
+    class DeferredDeletions
+       {
+        private:
+            struct Node
+               {
+                jobject* reference;
+                RefDeletionMethod deleteRef;
+                Node* next;
+               };
+
+            struct State
+               {
+                std::atomic<Node*> head { nullptr };
+                std::atomic<std::size_t> pending { 0 };
+                std::atomic<bool> shutdown { false };
+               };
+
+            static State& GetState()
+               {
+                static State state;
+                return state;
+               }
+
+            static JNIFunction DeletionFunction(RefDeletionMethod deleteRef)
+               {
+                if (deleteRef == &JNIEnv::DeleteLocalRef)
+                    return JNIFunction::DeleteLocalRef;
+                if (deleteRef == &JNIEnv::DeleteWeakGlobalRef)
+                    return JNIFunction::DeleteWeakGlobalRef;
+                return JNIFunction::DeleteGlobalRef;
+               }
+
+        public:
+            // Called from deleters, so does not throw; if a queue node can't be allocated, attaches
+            // and deletes the reference immediately instead.
+            static void Defer(JavaVM& vm, RefDeletionMethod deleteRef, jobject* reference) noexcept
+               {
+                State& state = GetState();
+                if (state.shutdown.load(std::memory_order_relaxed))
+                    return;
+
+                Node* node = new (std::nothrow) Node { reference, deleteRef, nullptr };
+                if (!node)
+                   {
+                    try
+                       {
+                        UniqueEnv attached = AttachCurrentThread(vm);
+                        Instrumentation::Call call(*attached, DeletionFunction(deleteRef));
+                        ((*attached).*deleteRef)(Unwrap(reference));
+                       }
+                    catch (...)
+                       {
+                       }
+                    return;
+                   }
+
+                // Counted before the push, so that Pending never underestimates.
+                state.pending.fetch_add(1, std::memory_order_relaxed);
+                node->next = state.head.load(std::memory_order_relaxed);
+                while (!state.head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed));
+               }
+
+            // Deletes all pending references using `env`. Returns the number deleted.
+            static std::size_t Flush(JNIEnv& env) noexcept
+               {
+                State& state = GetState();
+                Node* node = state.head.exchange(nullptr, std::memory_order_acquire);
+
+                std::size_t count = 0;
+                while (node)
+                   {
+                    Node* next = node->next;
+                       {
+                        Instrumentation::Call call(env, DeletionFunction(node->deleteRef));
+                        (env.*(node->deleteRef))(Unwrap(node->reference));
+                       }
+                    delete node;
+                    node = next;
+                    ++count;
+                   }
+
+                state.pending.fetch_sub(count, std::memory_order_relaxed);
+                return count;
+               }
+
+            // Deletes all pending references, attaching the current thread once if necessary.
+            static std::size_t Flush(JavaVM& vm)
+               {
+                if (!Pending())
+                    return 0;
+                return Flush(*GetAttachedEnv(vm));
+               }
+
+            // The number of references awaiting deletion. Approximate while deferrals are in progress.
+            static std::size_t Pending() noexcept
+               {
+                return GetState().pending.load(std::memory_order_relaxed);
+               }
+
+            static void Shutdown(JNIEnv& env) noexcept
+               {
+                GetState().shutdown.store(true);
+                Flush(env);
+               }
+       };
+
+    // A deleter that deletes the reference immediately if the current thread has a JVM attachment, and
+    // otherwise defers it to DeferredDeletions, rather than attaching and detaching as EnvAttachingDeleter
+    // does. Deleting on an attached thread also flushes any pending deferred deletions.
+    //
+    // Useful when many references may be released on native threads without a JVM attachment. In such
+    // cases, you may use one of the following:
+    //
+    //   low-level: UniqueGlobalRef<jobject, EnvDeferringDeleter> and NewGlobalRef<EnvDeferringDeleter>
+    //   high-level: Global<Object<Tag>, EnvDeferringDeleter> and obj.NewGlobalRef<EnvDeferringDeleter>
+    //
+    template < RefDeletionMethod DeleteRef >
+    class EnvDeferringDeleter
+       {
+        private:
+            JavaVM* vm = nullptr;
+
+        public:
+            EnvDeferringDeleter() = default;
+            EnvDeferringDeleter(JNIEnv& e) : vm(&GetJavaVM(e)) {}
+
+            void operator()(jobject* p) const
+               {
+                if (p)
+                   {
+                    assert(vm);
+                    ReferenceTracking::Deleted(ReferenceKindOf<DeleteRef>::value, p);
+                    JNIEnv* env = nullptr;
+                    jint err = vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_1);
+                    if (err == JNI_OK)
+                       {
+                           {
+                            Instrumentation::Call call(*env, JNIFunctionOf<DeleteRef>::value);
+                            (env->*DeleteRef)(Unwrap(p));
+                           }
+                        if (DeferredDeletions::Pending())
+                            DeferredDeletions::Flush(*env);
+                       }
+                    else if (err == JNI_EDETACHED)
+                       {
+                        DeferredDeletions::Defer(*vm, DeleteRef, p);
                        }
                     else
                        {
@@ -96,10 +270,12 @@ namespace jni
                 if (p)
                    {
                     assert(vm);
+                    ReferenceTracking::Deleted(ReferenceKindOf<DeleteRef>::value, p);
                     JNIEnv* env = nullptr;
                     jint err = vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_1);
                     if (err == JNI_OK)
                        {
+                        Instrumentation::Call call(*env, JNIFunctionOf<DeleteRef>::value);
                         (env->*DeleteRef)(Unwrap(p));
                        }
                     else if (err != JNI_EDETACHED)
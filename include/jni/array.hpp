@@ -5,6 +5,9 @@
 #include <jni/tagging.hpp>
 #include <jni/make.hpp>
 
+#include <algorithm>
+#include <vector>
+
 namespace jni
    {
     template < class E, class Enable >
@@ -48,9 +51,9 @@ namespace jni
                }
 
             template < class Array >
-            void GetRegion(JNIEnv& env, jsize start, Array& buf) const
+            void GetRegion(JNIEnv& env, jsize start, Array&& buf) const
                {
-                GetArrayRegion(env, SafeDereference(env, this->get()), start, buf);
+                GetArrayRegion(env, SafeDereference(env, this->get()), start, std::forward<Array>(buf));
                }
 
             template < class Array >
@@ -110,6 +113,147 @@ namespace jni
                }
       };
 
+    // Nested arrays, such as `float[][]`, which Java represents as arrays of references to arrays.
+    template < class E >
+    class Array< Array<E> > : public Object< ArrayTag<Array<E>> >
+       {
+        public:
+            using SuperType = Object< ArrayTag<Array<E>> >;
+            using UntaggedType = typename SuperType::UntaggedType;
+            using ElementType = Array<E>;
+            using UntaggedElementType = typename ElementType::UntaggedType;
+
+        protected:
+            explicit Array(std::nullptr_t = nullptr)
+               {}
+
+            explicit Array(UntaggedType* p)
+               : SuperType(p)
+               {}
+
+            Array(const Array&) = delete;
+            Array& operator=(const Array&) = delete;
+
+        public:
+            jsize Length(JNIEnv& env) const
+               {
+                return GetArrayLength(env, SafeDereference(env, this->get()));
+               }
+
+            Local<ElementType> Get(JNIEnv& env, jsize index) const
+               {
+                return Local<ElementType>(env,
+                    reinterpret_cast<UntaggedElementType*>(
+                        GetObjectArrayElement(env, SafeDereference(env, this->get()), index)));
+               }
+
+            void Set(JNIEnv& env, jsize index, const ElementType& value)
+               {
+                SetObjectArrayElement(env, SafeDereference(env, this->get()), index, Untag(value));
+               }
+
+            static Local<Array<Array<E>>> New(JNIEnv& env, jsize length, const ElementType* initialElement = nullptr)
+               {
+                return Local<Array<Array<E>>>(env, &NewObjectArray(env, length, *Class<ArrayTag<E>>::Singleton(env), initialElement ? initialElement->get() : nullptr));
+               }
+      };
+
+    // Calls `f` with each element of an object array. Elements are read in batches within a local
+    // frame, so that their references are released by one PopLocalFrame per batch rather than a
+    // DeleteLocalRef each. `f` may create up to `extraLocalsPerElement` further local references per
+    // element without releasing them.
+    template < class TheTag, class F >
+    void ForEachElement(JNIEnv& env, const Array<Object<TheTag>>& array, F&& f, jint extraLocalsPerElement = 0)
+       {
+        static const jsize batchSize = 64;
+
+        auto& untagged = SafeDereference(env, array.get());
+        const jsize length = GetArrayLength(env, untagged);
+
+        for (jsize start = 0; start < length; start += batchSize)
+           {
+            const jsize end = std::min(length, start + batchSize);
+            UniqueLocalFrame frame = PushLocalFrame(env, static_cast<jint>(end - start) * (1 + extraLocalsPerElement));
+
+            for (jsize i = start; i < end; ++i)
+               {
+                f(Object<TheTag>(reinterpret_cast<typename Object<TheTag>::UntaggedType*>(
+                    GetObjectArrayElement(env, untagged, i))));
+               }
+
+            ReleaseLocalFrame(env, std::move(frame));
+           }
+       }
+
+    // As above, for the rows of a nested array. `f` is called with a borrowed `const Array<E>&`.
+    template < class E, class F >
+    void ForEachElement(JNIEnv& env, const Array<Array<E>>& array, F&& f, jint extraLocalsPerElement = 0)
+       {
+        static const jsize batchSize = 64;
+
+        auto& untagged = SafeDereference(env, array.get());
+        const jsize length = GetArrayLength(env, untagged);
+
+        for (jsize start = 0; start < length; start += batchSize)
+           {
+            const jsize end = std::min(length, start + batchSize);
+            UniqueLocalFrame frame = PushLocalFrame(env, static_cast<jint>(end - start) * (1 + extraLocalsPerElement));
+
+            for (jsize i = start; i < end; ++i)
+               {
+                f(Input<Array<E>>(env, reinterpret_cast<typename Array<E>::UntaggedType*>(
+                    GetObjectArrayElement(env, untagged, i))));
+               }
+
+            ReleaseLocalFrame(env, std::move(frame));
+           }
+       }
+
+    // Streams the elements of a primitive array to `sink` in chunks of at most `chunkSize` elements,
+    // copying each chunk with GetArrayRegion into a single reused buffer. Peak memory is thus bounded
+    // by the chunk size rather than the array length. `sink` is called with a `Span<const E>` for each
+    // chunk, in order.
+    template < class E, class Sink >
+    auto GetArrayChunks(JNIEnv& env, const Array<E>& array, Sink&& sink, std::size_t chunkSize = 16384)
+       -> std::enable_if_t< IsPrimitive<E>::value >
+       {
+        auto& untagged = SafeDereference(env, array.get());
+        const std::size_t length = GetArrayLength(env, untagged);
+        std::vector<E> buffer(std::min(length, std::max<std::size_t>(chunkSize, 1)));
+
+        for (std::size_t start = 0; start < length; start += buffer.size())
+           {
+            const std::size_t count = std::min(buffer.size(), length - start);
+            GetArrayRegion(env, untagged, start, count, buffer.data());
+            sink(Span<const E>(buffer.data(), count));
+           }
+       }
+
+    // The reverse of GetArrayChunks: fills a primitive array from `source` in chunks of at most
+    // `chunkSize` elements. `source` is called with a `Span<E>` to fill, and returns the number of
+    // elements it wrote, or zero when it is exhausted. Returns the number of array elements set.
+    template < class E, class Source >
+    auto SetArrayChunks(JNIEnv& env, const Array<E>& array, Source&& source, std::size_t chunkSize = 16384)
+       -> std::enable_if_t< IsPrimitive<E>::value, std::size_t >
+       {
+        auto& untagged = SafeDereference(env, array.get());
+        const std::size_t length = GetArrayLength(env, untagged);
+        std::vector<E> buffer(std::min(length, std::max<std::size_t>(chunkSize, 1)));
+
+        std::size_t start = 0;
+        while (start < length)
+           {
+            const std::size_t capacity = std::min(buffer.size(), length - start);
+            const std::size_t count = std::min<std::size_t>(source(Span<E>(buffer.data(), capacity)), capacity);
+            if (count == 0)
+                break;
+            SetArrayRegion(env, untagged, start, count, buffer.data());
+            start += count;
+           }
+
+        return start;
+       }
+
     template < class T >
     std::vector<T> MakeAnything(ThingToMake<std::vector<T>>, JNIEnv& env, const Array<T>& array)
        {
@@ -127,6 +271,111 @@ namespace jni
         return result;
        }
 
+
+    // A dense representation of a nested primitive array: the rows are stored back to back in
+    // `values`, and row `i` occupies `values[offsets[i]]` up to `values[offsets[i + 1]]`. Rows may
+    // differ in length.
+    template < class T >
+    struct Matrix
+       {
+        std::vector<T> values;
+        std::vector<std::size_t> offsets { 0 };
+
+        std::size_t Rows() const { return offsets.size() - 1; }
+
+        Span<T>       Row(std::size_t i)       { return Span<T>(values.data() + offsets[i], offsets[i + 1] - offsets[i]); }
+        Span<const T> Row(std::size_t i) const { return Span<const T>(values.data() + offsets[i], offsets[i + 1] - offsets[i]); }
+
+        void AddRow(Span<const T> row)
+           {
+            values.insert(values.end(), row.begin(), row.end());
+            offsets.push_back(values.size());
+           }
+       };
+
+    // Conversions between nested primitive arrays and std::vector<std::vector<T>> or Matrix<T>.
+    // Rows are processed in batches within local frames, so the number of live local references is
+    // bounded regardless of the number of rows. A null row throws NullPointerException.
+
+    template < class T >
+    auto MakeAnything(ThingToMake<std::vector<std::vector<T>>>, JNIEnv& env, const Array<Array<T>>& array)
+       -> std::enable_if_t< IsPrimitive<T>::value, std::vector<std::vector<T>> >
+       {
+        std::vector<std::vector<T>> result;
+        result.reserve(array.Length(env));
+        ForEachElement(env, array, [&] (const Array<T>& row)
+           {
+            NullCheck(env, row.get());
+            result.emplace_back(GetArrayLength(env, *row));
+            GetArrayRegion(env, *row, 0, result.back());
+           });
+        return result;
+       }
+
+    template < class T >
+    auto MakeAnything(ThingToMake<Matrix<T>>, JNIEnv& env, const Array<Array<T>>& array)
+       -> std::enable_if_t< IsPrimitive<T>::value, Matrix<T> >
+       {
+        Matrix<T> result;
+        result.offsets.reserve(array.Length(env) + 1);
+        ForEachElement(env, array, [&] (const Array<T>& row)
+           {
+            NullCheck(env, row.get());
+            const std::size_t offset = result.values.size();
+            result.values.resize(offset + GetArrayLength(env, *row));
+            GetArrayRegion(env, *row, 0, result.values.size() - offset, result.values.data() + offset);
+            result.offsets.push_back(result.values.size());
+           });
+        return result;
+       }
+
+    template < class T, class RowAt >
+    Local<Array<Array<T>>> MakeNestedArray(JNIEnv& env, std::size_t rows, RowAt&& rowAt)
+       {
+        static const std::size_t batchSize = 64;
+
+        Local<Array<Array<T>>> result = Array<Array<T>>::New(env, rows);
+        auto& untagged = *result;
+
+        for (std::size_t start = 0; start < rows; start += batchSize)
+           {
+            const std::size_t end = std::min(rows, start + batchSize);
+            UniqueLocalFrame frame = PushLocalFrame(env, static_cast<jint>(end - start));
+
+            for (std::size_t i = start; i < end; ++i)
+               {
+                const auto row = rowAt(i);
+                auto& element = NewArray<T>(env, row.size());
+                SetArrayRegion(env, element, 0, row);
+                SetObjectArrayElement(env, untagged, i, &element);
+               }
+
+            ReleaseLocalFrame(env, std::move(frame));
+           }
+
+        return result;
+       }
+
+    template < class T >
+    auto MakeAnything(ThingToMake<Array<Array<T>>>, JNIEnv& env, const std::vector<std::vector<T>>& rows)
+       -> std::enable_if_t< IsPrimitive<T>::value, Local<Array<Array<T>>> >
+       {
+        return MakeNestedArray<T>(env, rows.size(), [&] (std::size_t i)
+           {
+            return Span<const T>(rows[i].data(), rows[i].size());
+           });
+       }
+
+    template < class T >
+    auto MakeAnything(ThingToMake<Array<Array<T>>>, JNIEnv& env, const Matrix<T>& matrix)
+       -> std::enable_if_t< IsPrimitive<T>::value, Local<Array<Array<T>>> >
+       {
+        return MakeNestedArray<T>(env, matrix.Rows(), [&] (std::size_t i)
+           {
+            return matrix.Row(i);
+           });
+       }
+
     inline
     std::string MakeAnything(ThingToMake<std::string>, JNIEnv& env, const Array<jbyte>& array)
        {
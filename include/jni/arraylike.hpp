@@ -4,38 +4,101 @@
 #include <string>
 #include <array>
 #include <vector>
+#include <stdexcept>
 
 namespace jni
    {
-    template < class T > struct IsArraylike: std::false_type {};
+    // A type is arraylike if it is a statically-sized array, or a contiguous range with `data()`
+    // (returning a pointer) and `size()` members -- e.g. std::array, std::vector, std::basic_string,
+    // jni::Span, or std::span and std::basic_string_view where available.
 
-    template < class E, std::size_t n >    struct IsArraylike< E[n]                     > : std::true_type {};
-    template < class E, std::size_t n >    struct IsArraylike< std::array<E,n>          > : std::true_type {};
-    template < class E, class A >          struct IsArraylike< std::vector<E,A>         > : std::true_type {};
-    template < class C, class T, class A > struct IsArraylike< std::basic_string<C,T,A> > : std::true_type {};
+    template < class T, class = void >
+    struct IsContiguousRange : std::false_type {};
 
+    template < class T >
+    struct IsContiguousRange< T, std::enable_if_t< std::is_pointer<decltype(std::declval<T&>().data())>::value
+                                                && std::is_convertible<decltype(std::declval<T&>().size()), std::size_t>::value > >
+        : std::true_type {};
 
-    template < class T > struct ArraylikeElementType;
 
-    template < class E, std::size_t n >    struct ArraylikeElementType< E[n]                     > { using Type = E; };
-    template < class E, std::size_t n >    struct ArraylikeElementType< std::array<E,n>          > { using Type = E; };
-    template < class E, class A >          struct ArraylikeElementType< std::vector<E,A>         > { using Type = E; };
-    template < class C, class T, class A > struct ArraylikeElementType< std::basic_string<C,T,A> > { using Type = C; };
+    template < class T, class = void > struct IsArraylike : std::false_type {};
 
-    template < class T > using ArraylikeElement = typename ArraylikeElementType<T>::type;
+    template < class E, std::size_t n > struct IsArraylike< E[n] > : std::true_type {};
+    template < class T >                struct IsArraylike< T, std::enable_if_t< IsContiguousRange<T>::value > > : std::true_type {};
+
+
+    template < class T, class = void > struct ArraylikeElementType;
+
+    template < class E, std::size_t n > struct ArraylikeElementType< E[n] > { using Type = E; };
+
+    template < class T >
+    struct ArraylikeElementType< T, std::enable_if_t< IsContiguousRange<T>::value > >
+       {
+        using Type = std::remove_const_t<std::remove_pointer_t<decltype(std::declval<T&>().data())>>;
+       };
+
+    template < class T > using ArraylikeElement = typename ArraylikeElementType<T>::Type;
 
 
     template < class E, std::size_t n >    E       * ArraylikeData(E(&a)[n])                              { return a; }
-    template < class E, std::size_t n >    E       * ArraylikeData(      std::array<E,n>& a)              { return a.data(); }
-    template < class E, std::size_t n >    E const * ArraylikeData(const std::array<E,n>& a)              { return a.data(); }
-    template < class E, class A >          E       * ArraylikeData(      std::vector<E,A>& a)             { return a.data(); }
-    template < class E, class A >          E const * ArraylikeData(const std::vector<E,A>& a)             { return a.data(); }
     template < class C, class T, class A > C       * ArraylikeData(      std::basic_string<C,T,A>& a)     { return &a[0]; }
     template < class C, class T, class A > C const * ArraylikeData(const std::basic_string<C,T,A>& a)     { return &a[0]; }
+    template < class A >                   auto      ArraylikeData(A& a) -> decltype(a.data())            { return a.data(); }
 
 
     template < class E, std::size_t n >    std::size_t ArraylikeSize(E(&)[n])                            { return n; }
-    template < class E, std::size_t n >    std::size_t ArraylikeSize(const std::array<E,n>&)             { return n; }
-    template < class E, class A >          std::size_t ArraylikeSize(const std::vector<E,A>& a)          { return a.size(); }
-    template < class C, class T, class A > std::size_t ArraylikeSize(const std::basic_string<C,T,A>& a)  { return a.size(); }
+
+    template < class A >
+    auto ArraylikeSize(const A& a) -> std::enable_if_t< IsContiguousRange<const A>::value, std::size_t >
+       {
+        return a.size();
+       }
+
+
+    // A non-owning view of a contiguous sequence of `E`, for passing part of a larger buffer -- a
+    // memory-mapped file, an arena, a ring buffer segment -- where an arraylike argument is accepted.
+    template < class E >
+    class Span
+       {
+        private:
+            E* ptr = nullptr;
+            std::size_t length = 0;
+
+        public:
+            Span() = default;
+            Span(E* p, std::size_t n) : ptr(p), length(n) {}
+
+            E* data() const { return ptr; }
+            std::size_t size() const { return length; }
+            bool empty() const { return length == 0; }
+
+            E* begin() const { return ptr; }
+            E* end() const { return ptr + length; }
+
+            E& operator[](std::size_t i) const { return ptr[i]; }
+       };
+
+    template < class E >
+    Span<E> MakeSpan(E* ptr, std::size_t length)
+       {
+        return Span<E>(ptr, length);
+       }
+
+    template < class E >
+    Span<E> MakeSpan(E* begin, E* end)
+       {
+        return Span<E>(begin, static_cast<std::size_t>(end - begin));
+       }
+
+    // A view of `count` elements of an arraylike, starting at `offset`. Throws std::out_of_range if
+    // the sub-range does not lie within the arraylike.
+    template < class A >
+    auto MakeSpan(A& a, std::size_t offset, std::size_t count)
+       -> std::enable_if_t< IsArraylike<std::remove_const_t<A>>::value, Span<std::remove_pointer_t<decltype(ArraylikeData(a))>> >
+       {
+        const std::size_t size = ArraylikeSize(a);
+        if (offset > size || count > size - offset)
+            throw std::out_of_range("jni::MakeSpan: sub-range out of bounds");
+        return MakeSpan(ArraylikeData(a) + offset, count);
+       }
    }
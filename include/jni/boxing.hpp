@@ -2,6 +2,13 @@
 
 #include <jni/class.hpp>
 #include <jni/object.hpp>
+#include <jni/array.hpp>
+#include <jni/type_signature.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
 
 namespace jni
    {
@@ -20,6 +27,12 @@ namespace jni
         return Unboxer<typename T::TagType>().Unbox(env, boxed);
        }
 
+    template < class T >
+    decltype(auto) UnboxField(JNIEnv& env, const T& boxed)
+       {
+        return Unboxer<typename T::TagType>().UnboxField(env, boxed);
+       }
+
 
     struct BooleanTag
        {
@@ -27,6 +40,7 @@ namespace jni
         static constexpr auto Name() { return "java/lang/Boolean"; }
         static constexpr auto BoxStaticMethodName() { return "valueOf"; }
         static constexpr auto UnboxMethodName() { return "booleanValue"; }
+        static constexpr auto UnboxFieldName() { return "value"; }
        };
 
     struct CharacterTag
@@ -35,6 +49,7 @@ namespace jni
         static constexpr auto Name() { return "java/lang/Character"; }
         static constexpr auto BoxStaticMethodName() { return "valueOf"; }
         static constexpr auto UnboxMethodName() { return "charValue"; }
+        static constexpr auto UnboxFieldName() { return "value"; }
        };
 
     struct NumberTag
@@ -49,6 +64,7 @@ namespace jni
         static constexpr auto Name() { return "java/lang/Byte"; }
         static constexpr auto BoxStaticMethodName() { return "valueOf"; }
         static constexpr auto UnboxMethodName() { return "byteValue"; }
+        static constexpr auto UnboxFieldName() { return "value"; }
        };
 
     struct ShortTag
@@ -57,6 +73,7 @@ namespace jni
         static constexpr auto Name() { return "java/lang/Short"; }
         static constexpr auto BoxStaticMethodName() { return "valueOf"; }
         static constexpr auto UnboxMethodName() { return "shortValue"; }
+        static constexpr auto UnboxFieldName() { return "value"; }
        };
 
     struct IntegerTag
@@ -65,6 +82,7 @@ namespace jni
         static constexpr auto Name() { return "java/lang/Integer"; }
         static constexpr auto BoxStaticMethodName() { return "valueOf"; }
         static constexpr auto UnboxMethodName() { return "intValue"; }
+        static constexpr auto UnboxFieldName() { return "value"; }
        };
 
     struct LongTag
@@ -73,6 +91,7 @@ namespace jni
         static constexpr auto Name() { return "java/lang/Long"; }
         static constexpr auto BoxStaticMethodName() { return "valueOf"; }
         static constexpr auto UnboxMethodName() { return "longValue"; }
+        static constexpr auto UnboxFieldName() { return "value"; }
        };
 
     struct FloatTag
@@ -81,6 +100,7 @@ namespace jni
         static constexpr auto Name() { return "java/lang/Float"; }
         static constexpr auto BoxStaticMethodName() { return "valueOf"; }
         static constexpr auto UnboxMethodName() { return "floatValue"; }
+        static constexpr auto UnboxFieldName() { return "value"; }
        };
 
     struct DoubleTag
@@ -89,6 +109,7 @@ namespace jni
         static constexpr auto Name() { return "java/lang/Double"; }
         static constexpr auto BoxStaticMethodName() { return "valueOf"; }
         static constexpr auto UnboxMethodName() { return "doubleValue"; }
+        static constexpr auto UnboxFieldName() { return "value"; }
        };
 
 
@@ -114,12 +135,42 @@ namespace jni
            }
        };
 
-    template <> struct Boxer< jboolean > : PrimitiveTypeBoxer< BooleanTag   , jboolean > {};
-    template <> struct Boxer< jbyte    > : PrimitiveTypeBoxer< ByteTag      , jbyte    > {};
-    template <> struct Boxer< jchar    > : PrimitiveTypeBoxer< CharacterTag , jchar    > {};
-    template <> struct Boxer< jshort   > : PrimitiveTypeBoxer< ShortTag     , jshort   > {};
-    template <> struct Boxer< jint     > : PrimitiveTypeBoxer< IntegerTag   , jint     > {};
-    template <> struct Boxer< jlong    > : PrimitiveTypeBoxer< LongTag      , jlong    > {};
+    // Java guarantees that valueOf returns canonical instances for the values in [Min, Max]. This
+    // boxer keeps global references to those instances the first time each is requested, and
+    // thereafter returns a new local reference to the cached instance, without calling valueOf.
+    // Like the class references held by Class<Tag>::Singleton, the cached references are never
+    // deleted.
+    template < class Tag, class Unboxed, jlong Min, jlong Max >
+    struct CachingPrimitiveTypeBoxer
+       {
+        Local<Object<Tag>> Box(JNIEnv& env, Unboxed unboxed) const
+           {
+            const std::uint64_t index = static_cast<std::uint64_t>(jlong(unboxed) - Min);
+            if (index > static_cast<std::uint64_t>(Max - Min))
+                return PrimitiveTypeBoxer<Tag, Unboxed>().Box(env, unboxed);
+
+            static std::array<std::atomic<jobject*>, std::size_t(Max - Min) + 1> cache {};
+            std::atomic<jobject*>& slot = cache[index];
+            jobject* cached = slot.load(std::memory_order_acquire);
+
+            if (!cached)
+               {
+                auto global = NewGlobal(env, PrimitiveTypeBoxer<Tag, Unboxed>().Box(env, unboxed));
+                if (slot.compare_exchange_strong(cached, global.get(), std::memory_order_acq_rel))
+                    cached = global.release();
+               }
+
+            return Local<Object<Tag>>(env,
+                reinterpret_cast<typename Object<Tag>::UntaggedType*>(NewLocalRef(env, cached).release()));
+           }
+       };
+
+    template <> struct Boxer< jboolean > : CachingPrimitiveTypeBoxer< BooleanTag   , jboolean ,    0 ,   1 > {};
+    template <> struct Boxer< jbyte    > : CachingPrimitiveTypeBoxer< ByteTag      , jbyte    , -128 , 127 > {};
+    template <> struct Boxer< jchar    > : CachingPrimitiveTypeBoxer< CharacterTag , jchar    ,    0 , 127 > {};
+    template <> struct Boxer< jshort   > : CachingPrimitiveTypeBoxer< ShortTag     , jshort   , -128 , 127 > {};
+    template <> struct Boxer< jint     > : CachingPrimitiveTypeBoxer< IntegerTag   , jint     , -128 , 127 > {};
+    template <> struct Boxer< jlong    > : CachingPrimitiveTypeBoxer< LongTag      , jlong    , -128 , 127 > {};
     template <> struct Boxer< jfloat   > : PrimitiveTypeBoxer< FloatTag     , jfloat   > {};
     template <> struct Boxer< jdouble  > : PrimitiveTypeBoxer< DoubleTag    , jdouble  > {};
 
@@ -133,6 +184,46 @@ namespace jni
             static auto unbox = klass.template GetMethod<Unboxed ()>(env, Tag::UnboxMethodName());
             return boxed.Call(env, unbox);
            }
+
+        // Reads the boxed type's private `value` field directly, rather than making a virtual call
+        // to the unboxing method. The boxed types are final, so the two are equivalent. If the
+        // field is not present in this runtime, falls back to the method.
+        Unboxed UnboxField(JNIEnv& env, const Object<Tag>& boxed) const
+           {
+            static jfieldID* field = ValueField(env);
+            if (!field)
+                return Unbox(env, boxed);
+
+            NullCheck(env, boxed.get());
+            Instrumentation::Call call(env, JNIFunction::GetField);
+            return Wrap<Unboxed>((env.*(TypedMethods<Unboxed>::GetField))(Unwrap(boxed.get()), Unwrap(*field)));
+           }
+
+        // Unboxes each element of the array, via UnboxField.
+        std::vector<Unboxed> Unbox(JNIEnv& env, const Array<Object<Tag>>& boxed) const
+           {
+            std::vector<Unboxed> result;
+            result.reserve(boxed.Length(env));
+            ForEachElement(env, boxed, [&] (const Object<Tag>& element)
+               {
+                result.push_back(UnboxField(env, element));
+               });
+            return result;
+           }
+
+        private:
+            static jfieldID* ValueField(JNIEnv& env)
+               {
+                try
+                   {
+                    return &GetFieldID(env, *Class<Tag>::Singleton(env), Tag::UnboxFieldName(), TypeSignature<Unboxed>()());
+                   }
+                catch (const PendingJavaException&)
+                   {
+                    ExceptionClear(env);
+                    return nullptr;
+                   }
+               }
        };
 
     template <> struct Unboxer< BooleanTag   > : PrimitiveTypeUnboxer< BooleanTag   , jboolean > {};
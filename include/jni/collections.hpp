@@ -0,0 +1,194 @@
+#pragma once
+
+#include <jni/class.hpp>
+#include <jni/object.hpp>
+#include <jni/array.hpp>
+#include <jni/constructor.hpp>
+#include <jni/method.hpp>
+#include <jni/static_method.hpp>
+#include <jni/boxing.hpp>
+#include <jni/make.hpp>
+
+#include <unordered_map>
+#include <vector>
+
+namespace jni
+   {
+    // Tags for the java.util collection interfaces. The type parameters are the high-level types
+    // of the elements, keys, and values, e.g. List<String> or Map<String, Long>; they affect only
+    // C++ type checking and conversions, not the Java class.
+
+    template < class E >
+    struct CollectionTag
+       {
+        static constexpr auto Name() { return "java/util/Collection"; }
+       };
+
+    template < class E >
+    struct ListTag
+       {
+        using SuperTag = CollectionTag<E>;
+        static constexpr auto Name() { return "java/util/List"; }
+       };
+
+    template < class E >
+    struct SetTag
+       {
+        using SuperTag = CollectionTag<E>;
+        static constexpr auto Name() { return "java/util/Set"; }
+       };
+
+    template < class K, class V >
+    struct MapTag
+       {
+        static constexpr auto Name() { return "java/util/Map"; }
+       };
+
+    template < class K, class V >
+    struct MapEntryTag
+       {
+        static constexpr auto Name() { return "java/util/Map$Entry"; }
+       };
+
+    struct ArraysTag    { static constexpr auto Name() { return "java/util/Arrays"; } };
+    struct ArrayListTag { static constexpr auto Name() { return "java/util/ArrayList"; } };
+    struct HashMapTag   { static constexpr auto Name() { return "java/util/HashMap"; } };
+
+
+    template < class E >         using Collection = Object<CollectionTag<E>>;
+    template < class E >         using List       = Object<ListTag<E>>;
+    template < class E >         using Set        = Object<SetTag<E>>;
+    template < class K, class V > using Map        = Object<MapTag<K, V>>;
+
+
+    // Conversions between Java collection elements and C++ values: primitive C++ types are boxed
+    // and unboxed, and other types are converted with Make.
+
+    template < class T, class E >
+    auto MakeElement(JNIEnv& env, const E& element)
+       -> std::enable_if_t< IsPrimitive<T>::value, T >
+       {
+        return UnboxField(env, element);
+       }
+
+    template < class T, class E >
+    auto MakeElement(JNIEnv& env, const E& element)
+       -> std::enable_if_t< !IsPrimitive<T>::value, T >
+       {
+        return Make<T>(env, element);
+       }
+
+    template < class E, class T >
+    auto MakeJavaElement(JNIEnv& env, const T& value)
+       -> std::enable_if_t< IsPrimitive<T>::value, Local<E> >
+       {
+        return Box(env, value);
+       }
+
+    template < class E, class T >
+    auto MakeJavaElement(JNIEnv& env, const T& value)
+       -> std::enable_if_t< !IsPrimitive<T>::value, Local<E> >
+       {
+        return Make<E>(env, value);
+       }
+
+    template < class T, class E >
+    T MakeElement(JNIEnv& env, const Object<>& element, ThingToMake<E>)
+       {
+        return MakeElement<T>(env, E(reinterpret_cast<typename E::UntaggedType*>(element.get())));
+       }
+
+
+    // Collections are converted with a single call to toArray(), rather than with an iterator, and
+    // the elements of the resulting array are read in batches within local frames.
+    template < class T, class E >
+    std::vector<T> MakeAnything(ThingToMake<std::vector<T>>, JNIEnv& env, const Collection<E>& collection)
+       {
+        static auto& klass = Class<CollectionTag<E>>::Singleton(env);
+        static auto toArray = klass.template GetMethod<Array<Object<>> ()>(env, "toArray");
+
+        NullCheck(env, collection.get());
+        auto array = collection.Call(env, toArray);
+
+        std::vector<T> result;
+        result.reserve(array.Length(env));
+        ForEachElement(env, array, [&] (const Object<>& element)
+           {
+            result.push_back(MakeElement<T>(env, element, ThingToMake<E>()));
+           });
+        return result;
+       }
+
+    // Maps are converted with a single call to entrySet().toArray(), followed by getKey() and
+    // getValue() for each entry.
+    template < class K, class V, class KE, class VE >
+    std::unordered_map<K, V> MakeAnything(ThingToMake<std::unordered_map<K, V>>, JNIEnv& env, const Map<KE, VE>& map)
+       {
+        using EntryTag = MapEntryTag<KE, VE>;
+
+        static auto& mapClass = Class<MapTag<KE, VE>>::Singleton(env);
+        static auto entrySet = mapClass.template GetMethod<Set<Object<EntryTag>> ()>(env, "entrySet");
+        static auto& collectionClass = Class<CollectionTag<Object<EntryTag>>>::Singleton(env);
+        static auto toArray = collectionClass.template GetMethod<Array<Object<>> ()>(env, "toArray");
+        static auto& entryClass = Class<EntryTag>::Singleton(env);
+        static auto getKey = entryClass.template GetMethod<Object<> ()>(env, "getKey");
+        static auto getValue = entryClass.template GetMethod<Object<> ()>(env, "getValue");
+
+        NullCheck(env, map.get());
+        auto entries = map.Call(env, entrySet);
+        const Collection<Object<EntryTag>>& collection = entries;
+        auto array = collection.Call(env, toArray);
+
+        std::unordered_map<K, V> result;
+        result.reserve(array.Length(env));
+        ForEachElement(env, array, [&] (const Object<>& element)
+           {
+            const Object<EntryTag> entry(element.get());
+            const Object<> key(entry.Call(env, getKey).release());
+            const Object<> value(entry.Call(env, getValue).release());
+            result.emplace(MakeElement<K>(env, key, ThingToMake<KE>()),
+                           MakeElement<V>(env, value, ThingToMake<VE>()));
+           }, 2);
+        return result;
+       }
+
+    // Lists are created by filling an Object[] and copying it into an ArrayList with
+    // new ArrayList(Arrays.asList(array)).
+    template < class E, class T >
+    Local<List<E>> MakeAnything(ThingToMake<List<E>>, JNIEnv& env, const std::vector<T>& vector)
+       {
+        static auto& arraysClass = Class<ArraysTag>::Singleton(env);
+        static auto asList = arraysClass.template GetStaticMethod<List<E> (Array<Object<>>)>(env, "asList");
+        static auto& arrayListClass = Class<ArrayListTag>::Singleton(env);
+        static auto constructor = arrayListClass.template GetConstructor<Collection<E>>(env);
+
+        auto array = Array<Object<>>::New(env, vector.size());
+        for (std::size_t i = 0; i < vector.size(); ++i)
+           {
+            array.Set(env, i, MakeJavaElement<E>(env, vector[i]));
+           }
+
+        auto list = arraysClass.Call(env, asList, array);
+        return Local<List<E>>(env, arrayListClass.New(env, constructor, list).release());
+       }
+
+    template < class KE, class VE, class K, class V >
+    Local<Map<KE, VE>> MakeAnything(ThingToMake<Map<KE, VE>>, JNIEnv& env, const std::unordered_map<K, V>& map)
+       {
+        static auto& hashMapClass = Class<HashMapTag>::Singleton(env);
+        static auto constructor = hashMapClass.template GetConstructor<jint>(env);
+        static auto& mapClass = Class<MapTag<KE, VE>>::Singleton(env);
+        static auto put = mapClass.template GetMethod<Object<> (Object<>, Object<>)>(env, "put");
+
+        Local<Map<KE, VE>> result(env, hashMapClass.New(env, constructor, static_cast<jint>(map.size() * 4 / 3 + 1)).release());
+
+        for (const auto& entry : map)
+           {
+            result.Call(env, put,
+                MakeJavaElement<KE>(env, entry.first),
+                MakeJavaElement<VE>(env, entry.second));
+           }
+
+        return result;
+       }
+   }
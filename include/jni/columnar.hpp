@@ -0,0 +1,87 @@
+#pragma once
+
+#include <jni/functions.hpp>
+#include <jni/array.hpp>
+#include <jni/make.hpp>
+
+#include <array>
+#include <initializer_list>
+#include <tuple>
+#include <vector>
+
+namespace jni
+   {
+    // Columnar conversion between a vector of structs and one primitive Java array per member.
+    // Transferring N records as a handful of arrays, each copied with a single SetArrayRegion or
+    // GetArrayRegion, avoids creating N Java objects.
+    //
+    //   auto columns = jni::MakeColumns(env, points, &Point::x, &Point::y);
+    //   // std::tuple<Local<Array<jint>>, Local<Array<jdouble>>>
+    //
+    //   auto points = jni::MakeRows<Point>(env, jni::Column(&Point::x, xs), jni::Column(&Point::y, ys));
+    //
+    // Mapped members must have jni.hpp primitive types.
+
+    template < class Struct, class T >
+    Local<Array<T>> MakeColumn(JNIEnv& env, const std::vector<Struct>& rows, T Struct::* member)
+       {
+        std::vector<T> column;
+        column.reserve(rows.size());
+        for (const Struct& row : rows)
+           {
+            column.push_back(row.*member);
+           }
+        return Make<Array<T>>(env, column);
+       }
+
+    template < class Struct, class... Ts >
+    std::tuple<Local<Array<Ts>>...> MakeColumns(JNIEnv& env, const std::vector<Struct>& rows, Ts Struct::*... members)
+       {
+        return std::tuple<Local<Array<Ts>>...>(MakeColumn(env, rows, members)...);
+       }
+
+
+    template < class Struct, class T >
+    struct ColumnSource
+       {
+        T Struct::* member;
+        const Array<T>& array;
+       };
+
+    template < class Struct, class T >
+    ColumnSource<Struct, T> Column(T Struct::* member, const Array<T>& array)
+       {
+        return { member, array };
+       }
+
+    template < class Struct, class T >
+    int GatherColumn(JNIEnv& env, std::vector<Struct>& rows, const ColumnSource<Struct, T>& column)
+       {
+        std::vector<T> values(rows.size());
+        GetArrayRegion(env, *column.array, 0, values);
+        for (std::size_t i = 0; i < rows.size(); ++i)
+           {
+            rows[i].*(column.member) = values[i];
+           }
+        return 0;
+       }
+
+    // Throws IllegalArgumentException if the columns differ in length. Struct must be default
+    // constructible; members not named by a column are value-initialized.
+    template < class Struct, class... Ts >
+    std::vector<Struct> MakeRows(JNIEnv& env, const ColumnSource<Struct, Ts>&... columns)
+       {
+        static_assert(sizeof...(Ts) > 0, "at least one column is required");
+
+        const std::array<jsize, sizeof...(Ts)> lengths {{ columns.array.Length(env)... }};
+        for (jsize length : lengths)
+           {
+            if (length != lengths[0])
+                ThrowNew(env, FindClass(env, "java/lang/IllegalArgumentException"), "column lengths differ");
+           }
+
+        std::vector<Struct> rows(lengths[0]);
+        (void)std::initializer_list<int> { GatherColumn(env, rows, columns)... };
+        return rows;
+       }
+   }
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <jni/functions.hpp>
+#include <jni/array.hpp>
+#include <jni/string.hpp>
+#include <jni/npe.hpp>
+
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <new>
+#include <tuple>
+#include <utility>
+
+namespace jni
+   {
+    template < class T >
+    struct CriticalTraits;
+
+    template < class E >
+    struct CriticalTraits< Array<E> >
+       {
+        static_assert(IsPrimitive<E>::value, "only primitive arrays can be pinned");
+
+        using ElementType = E;
+
+        static std::size_t Length(JNIEnv& env, jarray<E>& array)
+           {
+            return GetArrayLength(env, array);
+           }
+
+        static void* Acquire(JNIEnv& env, jarray<E>& array)
+           {
+            Instrumentation::Call call(env, JNIFunction::GetPrimitiveArrayCritical);
+            return env.GetPrimitiveArrayCritical(Unwrap(array), nullptr);
+           }
+
+        static void Release(JNIEnv& env, jarray<E>& array, void* elements, jint mode)
+           {
+            Instrumentation::Call call(env, JNIFunction::ReleasePrimitiveArrayCritical);
+            env.ReleasePrimitiveArrayCritical(Unwrap(array), elements, mode);
+           }
+       };
+
+    template <>
+    struct CriticalTraits< String >
+       {
+        using ElementType = const char16_t;
+
+        static std::size_t Length(JNIEnv& env, jstring& string)
+           {
+            return GetStringLength(env, string);
+           }
+
+        static void* Acquire(JNIEnv& env, jstring& string)
+           {
+            Instrumentation::Call call(env, JNIFunction::GetStringCritical);
+            return const_cast<char16_t*>(Wrap<const char16_t*>(env.GetStringCritical(Unwrap(string), nullptr)));
+           }
+
+        static void Release(JNIEnv& env, jstring& string, void* chars, jint)
+           {
+            Instrumentation::Call call(env, JNIFunction::ReleaseStringCritical);
+            env.ReleaseStringCritical(Unwrap(string), Unwrap(static_cast<const char16_t*>(chars)));
+           }
+       };
+
+
+    // Pins several primitive arrays and strings at once, e.g. to run a kernel over the x, y, and z
+    // coordinate arrays of a geometry without copying them:
+    //
+    //   auto section = jni::MakeCriticalSection(env, xs, ys, zs);
+    //   jni::Span<jni::jdouble> x = section.Get<0>();
+    //
+    // Lengths are read before anything is pinned. If pinning any object fails, those already
+    // pinned are released, and PendingJavaException (or std::bad_alloc, if no exception is
+    // pending) is thrown. On destruction, objects are released in reverse order of pinning, and
+    // array changes are written back unless Discard() was called.
+    //
+    // No other JNI function may be called while a section is live. In builds without NDEBUG,
+    // CheckJavaException -- which nearly every jni.hpp wrapper calls -- asserts this.
+    template < class... Ts >
+    class CriticalSection
+       {
+        private:
+            static constexpr std::size_t count = sizeof...(Ts);
+
+            using Objects = std::tuple<typename Ts::UntaggedType*...>;
+
+            JNIEnv* env;
+            Objects objects;
+            std::array<std::size_t, count> lengths;
+            std::array<void*, count> pointers {};
+            jint mode = 0;
+
+            template < std::size_t... Is >
+            void Acquire(std::index_sequence<Is...>)
+               {
+                std::size_t pinned = 0;
+                (void)std::initializer_list<bool> {
+                    (pinned == Is && (pointers[Is] = CriticalTraits<Ts>::Acquire(*env, *std::get<Is>(objects))) && ++pinned)... };
+
+                if (pinned < count)
+                   {
+                    Release(pinned, std::index_sequence<Is...>());
+                    CheckJavaException(*env);
+                    throw std::bad_alloc();
+                   }
+               }
+
+            template < std::size_t... Is >
+            void Release(std::size_t pinned, std::index_sequence<Is...>)
+               {
+                using Releaser = void (*)(JNIEnv&, const Objects&, void*, jint);
+                static const Releaser releasers[] = { &ReleaseOne<Is>... };
+
+                while (pinned > 0)
+                   {
+                    --pinned;
+                    releasers[pinned](*env, objects, pointers[pinned], mode);
+                    pointers[pinned] = nullptr;
+                   }
+               }
+
+            template < std::size_t I >
+            static void ReleaseOne(JNIEnv& env, const Objects& objects, void* pointer, jint mode)
+               {
+                CriticalTraits<std::tuple_element_t<I, std::tuple<Ts...>>>::Release(env, *std::get<I>(objects), pointer, mode);
+               }
+
+        public:
+            CriticalSection(JNIEnv& e, const Ts&... ts)
+               : env(&e),
+                 objects(&SafeDereference(e, ts.get())...),
+                 lengths {{ CriticalTraits<Ts>::Length(e, *ts.get())... }}
+               {
+                Acquire(std::index_sequence_for<Ts...>());
+#ifndef NDEBUG
+                ++CriticalSectionDepth();
+#endif
+               }
+
+            CriticalSection(CriticalSection&& other)
+               : env(other.env),
+                 objects(other.objects),
+                 lengths(other.lengths),
+                 pointers(other.pointers),
+                 mode(other.mode)
+               {
+                other.env = nullptr;
+               }
+
+            CriticalSection(const CriticalSection&) = delete;
+            CriticalSection& operator=(const CriticalSection&) = delete;
+            CriticalSection& operator=(CriticalSection&&) = delete;
+
+            ~CriticalSection()
+               {
+                if (!env)
+                    return;
+#ifndef NDEBUG
+                --CriticalSectionDepth();
+#endif
+                Release(count, std::index_sequence_for<Ts...>());
+               }
+
+            template < std::size_t I >
+            Span<typename CriticalTraits<std::tuple_element_t<I, std::tuple<Ts...>>>::ElementType> Get() const
+               {
+                using Element = typename CriticalTraits<std::tuple_element_t<I, std::tuple<Ts...>>>::ElementType;
+                return Span<Element>(static_cast<Element*>(pointers[I]), lengths[I]);
+               }
+
+            // Release arrays with JNI_ABORT, so that changes to copies are not written back. Use
+            // this for read-only kernels, to avoid the copy back on VMs that do not pin.
+            void Discard()
+               {
+                mode = JNI_ABORT;
+               }
+       };
+
+    template < class... Ts >
+    CriticalSection<RemoveUniqueType<Ts>...> MakeCriticalSection(JNIEnv& env, const Ts&... ts)
+       {
+        return CriticalSection<RemoveUniqueType<Ts>...>(env, ts...);
+       }
+   }
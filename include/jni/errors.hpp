@@ -2,7 +2,9 @@
 
 #include <jni/types.hpp>
 #include <jni/traits.hpp>
+#include <jni/instrumentation.hpp>
 
+#include <cassert>
 #include <system_error>
 #include <string>
 
@@ -13,6 +15,9 @@ namespace std
 
 namespace jni
    {
+    // The instrumentation policy for the wrappers in functions.hpp; see instrumentation.hpp.
+    using Instrumentation = InstrumentationPolicy<>::Type;
+
     inline const std::error_category& ErrorCategory()
        {
         class Impl : public std::error_category
@@ -57,10 +62,21 @@ namespace jni
 
     class PendingJavaException {};
 
+
+    // The number of CriticalSections live on the current thread. Only maintained in builds without
+    // NDEBUG, where it is used to assert that no JNI functions are called within a critical section.
+    inline int& CriticalSectionDepth()
+       {
+        static thread_local int depth = 0;
+        return depth;
+       }
+
     template < class R >
     R CheckJavaException(JNIEnv& env, R&& r)
        {
+        assert(CriticalSectionDepth() == 0 && "JNI function called within a critical section");
         if (env.ExceptionCheck()) {
+            Instrumentation::JavaException(env);
             env.ExceptionDescribe();
             throw PendingJavaException();
         }
@@ -69,7 +85,9 @@ namespace jni
 
     inline void CheckJavaException(JNIEnv& env)
        {
+        assert(CriticalSectionDepth() == 0 && "JNI function called within a critical section");
         if (env.ExceptionCheck()) {
+            Instrumentation::JavaException(env);
             env.ExceptionDescribe();
             throw PendingJavaException();
         }
@@ -84,9 +102,18 @@ namespace jni
 
     inline ::jclass JavaErrorClass(JNIEnv& env)
        {
+        Instrumentation::Call call(env, JNIFunction::FindClass);
         return env.FindClass("java/lang/Error");
        }
 
+    // Leaves a pending java.lang.Error with the given message.
+    inline void ThrowJavaError(JNIEnv& env, const char* message)
+       {
+        ::jclass clazz = JavaErrorClass(env);
+        Instrumentation::Call call(env, JNIFunction::ThrowNew);
+        env.ThrowNew(clazz, message);
+       }
+
     // A function to be called from within a try / catch wrapper for a native method:
     //
     //   void nativeMethod(JNIEnv* env, ...)
@@ -115,11 +142,11 @@ namespace jni
            }
         catch (const std::exception& e)
            {
-            env.ThrowNew(JavaErrorClass(env), e.what());
+            ThrowJavaError(env, e.what());
            }
         catch (...)
            {
-            env.ThrowNew(JavaErrorClass(env), "unknown native exception");
+            ThrowJavaError(env, "unknown native exception");
            }
        }
    }
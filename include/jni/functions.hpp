@@ -12,16 +12,35 @@
 
 namespace jni
    {
+    // Reports a local reference returned by a JNI function to the ReferenceTracking policy.
+    template < class T >
+    std::enable_if_t< std::is_convertible<T, const jobject*>::value, T >
+    TrackLocal(JNIFunction function, T reference)
+       {
+        ReferenceTracking::Created(ReferenceKind::Local, function, reference);
+        return reference;
+       }
+
+    template < class T >
+    std::enable_if_t< !std::is_convertible<T, const jobject*>::value, T >
+    TrackLocal(JNIFunction, T value)
+       {
+        return value;
+       }
+
+
     inline jint GetVersion(JNIEnv& env)
        {
+        Instrumentation::Call call(env, JNIFunction::GetVersion);
         return env.GetVersion();
        }
 
 
     inline jclass& DefineClass(JNIEnv& env, const char* name, jobject& loader, const jbyte* buf, jsize size)
        {
+        Instrumentation::Call call(env, JNIFunction::DefineClass);
         return *CheckJavaException(env,
-            Wrap<jclass*>(env.DefineClass(name, Unwrap(loader), buf, Unwrap(size))));
+            TrackLocal(JNIFunction::DefineClass, Wrap<jclass*>(env.DefineClass(name, Unwrap(loader), buf, Unwrap(size)))));
        }
 
     template < class Array >
@@ -33,43 +52,50 @@ namespace jni
 
     inline jclass& FindClass(JNIEnv& env, const char* name)
        {
-        return *CheckJavaException(env, Wrap<jclass*>(env.FindClass(name)));
+        Instrumentation::Call call(env, JNIFunction::FindClass);
+        return *CheckJavaException(env, TrackLocal(JNIFunction::FindClass, Wrap<jclass*>(env.FindClass(name))));
        }
 
 
     inline jmethodID* FromReflectedMethod(JNIEnv& env, jobject* obj)
        {
+        Instrumentation::Call call(env, JNIFunction::FromReflectedMethod);
         return CheckJavaException(env,
             Wrap<jmethodID*>(env.FromReflectedMethod(Unwrap(obj))));
        }
 
     inline jfieldID* FromReflectedField(JNIEnv& env, jobject* obj)
        {
+        Instrumentation::Call call(env, JNIFunction::FromReflectedField);
         return CheckJavaException(env,
             Wrap<jfieldID*>(env.FromReflectedField(Unwrap(obj))));
        }
 
     inline jobject& ToReflectedMethod(JNIEnv& env, jclass& clazz, jmethodID& method, bool isStatic)
        {
+        Instrumentation::Call call(env, JNIFunction::ToReflectedMethod);
         return *CheckJavaException(env,
-            Wrap<jobject*>(env.ToReflectedMethod(Unwrap(clazz), Unwrap(method), isStatic)));
+            TrackLocal(JNIFunction::ToReflectedMethod, Wrap<jobject*>(env.ToReflectedMethod(Unwrap(clazz), Unwrap(method), isStatic))));
        }
 
     inline jobject& ToReflectedField(JNIEnv& env, jclass& clazz, jfieldID& field, bool isStatic)
        {
+        Instrumentation::Call call(env, JNIFunction::ToReflectedField);
         return *CheckJavaException(env,
-            Wrap<jobject*>(env.ToReflectedField(Unwrap(clazz), Unwrap(field), isStatic)));
+            TrackLocal(JNIFunction::ToReflectedField, Wrap<jobject*>(env.ToReflectedField(Unwrap(clazz), Unwrap(field), isStatic))));
        }
 
 
     inline jclass* GetSuperclass(JNIEnv& env, jclass& clazz)
        {
+        Instrumentation::Call call(env, JNIFunction::GetSuperclass);
         return CheckJavaException(env,
-            Wrap<jclass*>(env.GetSuperclass(Unwrap(clazz))));
+            TrackLocal(JNIFunction::GetSuperclass, Wrap<jclass*>(env.GetSuperclass(Unwrap(clazz)))));
        }
 
     inline bool IsAssignableFrom(JNIEnv& env, jclass& clazz1, jclass& clazz2)
        {
+        Instrumentation::Call call(env, JNIFunction::IsAssignableFrom);
         return CheckJavaException(env,
             env.IsAssignableFrom(Unwrap(clazz1), Unwrap(clazz2)));
        }
@@ -77,38 +103,45 @@ namespace jni
 
     [[noreturn]] inline void Throw(JNIEnv& env, jthrowable& obj)
        {
+        Instrumentation::Call call(env, JNIFunction::Throw);
         CheckErrorCode(env.Throw(Unwrap(obj)));
         throw PendingJavaException();
        }
 
     [[noreturn]] inline void ThrowNew(JNIEnv& env, jclass& clazz, const char* msg = nullptr)
        {
+        Instrumentation::Call call(env, JNIFunction::ThrowNew);
         CheckErrorCode(env.ThrowNew(Unwrap(clazz), msg));
         throw PendingJavaException();
        }
 
     inline bool ExceptionCheck(JNIEnv& env)
        {
+        Instrumentation::Call call(env, JNIFunction::ExceptionCheck);
         return env.ExceptionCheck();
        }
 
     inline jthrowable* ExceptionOccurred(JNIEnv& env)
        {
-        return Wrap<jthrowable*>(env.ExceptionOccurred());
+        Instrumentation::Call call(env, JNIFunction::ExceptionOccurred);
+        return TrackLocal(JNIFunction::ExceptionOccurred, Wrap<jthrowable*>(env.ExceptionOccurred()));
        }
 
     inline void ExceptionDescribe(JNIEnv& env)
        {
+        Instrumentation::Call call(env, JNIFunction::ExceptionDescribe);
         env.ExceptionDescribe();
        }
 
     inline void ExceptionClear(JNIEnv& env)
        {
+        Instrumentation::Call call(env, JNIFunction::ExceptionClear);
         env.ExceptionClear();
        }
 
     [[noreturn]] inline void FatalError(JNIEnv& env, const char* msg)
        {
+        Instrumentation::Call call(env, JNIFunction::FatalError);
         env.FatalError(msg);
         std::abort();
        }
@@ -116,22 +149,41 @@ namespace jni
 
     inline UniqueLocalFrame PushLocalFrame(JNIEnv& env, jint capacity)
        {
+        Instrumentation::Call call(env, JNIFunction::PushLocalFrame);
         CheckJavaExceptionThenErrorCode(env, env.PushLocalFrame(capacity));
+        ReferenceTracking::FramePushed();
         return UniqueLocalFrame(&env, LocalFrameDeleter());
        }
 
     inline jobject* PopLocalFrame(JNIEnv& env, UniqueLocalFrame&& frame, jobject* result = nullptr)
        {
+        Instrumentation::Call call(env, JNIFunction::PopLocalFrame);
         frame.release();
+        ReferenceTracking::Deleted(ReferenceKind::Local, result);
+        ReferenceTracking::FramePopped();
         return CheckJavaException(env,
-            Wrap<jobject*>(env.PopLocalFrame(Unwrap(result))));
+            TrackLocal(JNIFunction::PopLocalFrame, Wrap<jobject*>(env.PopLocalFrame(Unwrap(result)))));
+       }
+
+    // Pops a frame whose remaining local references are released deliberately, such as one that
+    // batches the references created by a loop. ReferenceTracking counts them as released rather
+    // than leaked.
+    inline void ReleaseLocalFrame(JNIEnv& env, UniqueLocalFrame&& frame)
+       {
+        Instrumentation::Call call(env, JNIFunction::PopLocalFrame);
+        frame.release();
+        ReferenceTracking::FrameReleased();
+        env.PopLocalFrame(nullptr);
+        CheckJavaException(env);
        }
 
 
     template < template < RefDeletionMethod > class Deleter, class T >
     UniqueGlobalRef<T, Deleter> NewGlobalRef(JNIEnv& env, T* t)
        {
+        Instrumentation::Call call(env, JNIFunction::NewGlobalRef);
         jobject* obj = Wrap<jobject*>(env.NewGlobalRef(Unwrap(t)));
+        ReferenceTracking::Created(ReferenceKind::Global, JNIFunction::NewGlobalRef, obj);
         CheckJavaException(env);
         if (t && !obj)
             throw std::bad_alloc();
@@ -149,7 +201,9 @@ namespace jni
     template < template < RefDeletionMethod > class Deleter, class T, template < RefDeletionMethod > class WeakDeleter >
     UniqueGlobalRef<T, Deleter> NewGlobalRef(JNIEnv& env, const UniqueWeakGlobalRef<T, WeakDeleter>& t)
        {
+        Instrumentation::Call call(env, JNIFunction::NewGlobalRef);
         jobject* obj = Wrap<jobject*>(env.NewGlobalRef(Unwrap(t)));
+        ReferenceTracking::Created(ReferenceKind::Global, JNIFunction::NewGlobalRef, obj);
         CheckJavaException(env);
         return UniqueGlobalRef<T, Deleter>(reinterpret_cast<T*>(obj), Deleter<&JNIEnv::DeleteGlobalRef>(env));
        }
@@ -163,6 +217,8 @@ namespace jni
     template < class T, template < RefDeletionMethod > class Deleter >
     void DeleteGlobalRef(JNIEnv& env, UniqueGlobalRef<T, Deleter>&& ref)
        {
+        Instrumentation::Call call(env, JNIFunction::DeleteGlobalRef);
+        ReferenceTracking::Deleted(ReferenceKind::Global, ref.get());
         env.DeleteGlobalRef(Unwrap(ref.release()));
         CheckJavaException(env);
        }
@@ -171,7 +227,9 @@ namespace jni
     template < class T >
     UniqueLocalRef<T> NewLocalRef(JNIEnv& env, T* t)
        {
+        Instrumentation::Call call(env, JNIFunction::NewLocalRef);
         jobject* obj = Wrap<jobject*>(env.NewLocalRef(Unwrap(t)));
+        ReferenceTracking::Created(ReferenceKind::Local, JNIFunction::NewLocalRef, obj);
         CheckJavaException(env);
         if (t && !obj)
             throw std::bad_alloc();
@@ -183,7 +241,9 @@ namespace jni
     template < class T, template < RefDeletionMethod > class WeakDeleter >
     UniqueLocalRef<T> NewLocalRef(JNIEnv& env, const UniqueWeakGlobalRef<T, WeakDeleter>& t)
        {
+        Instrumentation::Call call(env, JNIFunction::NewLocalRef);
         jobject* obj = Wrap<jobject*>(env.NewLocalRef(Unwrap(t)));
+        ReferenceTracking::Created(ReferenceKind::Local, JNIFunction::NewLocalRef, obj);
         CheckJavaException(env);
         return UniqueLocalRef<T>(reinterpret_cast<T*>(obj), DefaultRefDeleter<&JNIEnv::DeleteLocalRef>(env));
        }
@@ -191,12 +251,15 @@ namespace jni
     template < class T >
     void DeleteLocalRef(JNIEnv& env, UniqueLocalRef<T>&& ref)
        {
+        Instrumentation::Call call(env, JNIFunction::DeleteLocalRef);
+        ReferenceTracking::Deleted(ReferenceKind::Local, ref.get());
         env.DeleteLocalRef(Unwrap(ref.release()));
         CheckJavaException(env);
        }
 
     inline void EnsureLocalCapacity(JNIEnv& env, jint capacity)
        {
+        Instrumentation::Call call(env, JNIFunction::EnsureLocalCapacity);
         CheckJavaExceptionThenErrorCode(env, env.EnsureLocalCapacity(capacity));
        }
 
@@ -204,7 +267,9 @@ namespace jni
     template < template < RefDeletionMethod > class Deleter, class T >
     UniqueWeakGlobalRef<T, Deleter> NewWeakGlobalRef(JNIEnv& env, T* t)
        {
+        Instrumentation::Call call(env, JNIFunction::NewWeakGlobalRef);
         jobject* obj = Wrap<jobject*>(env.NewWeakGlobalRef(Unwrap(t)));
+        ReferenceTracking::Created(ReferenceKind::WeakGlobal, JNIFunction::NewWeakGlobalRef, obj);
         CheckJavaException(env);
         if (t && !obj)
             throw std::bad_alloc();
@@ -220,6 +285,8 @@ namespace jni
     template < class T, template < RefDeletionMethod > class Deleter >
     void DeleteWeakGlobalRef(JNIEnv& env, UniqueWeakGlobalRef<T, Deleter>&& ref)
        {
+        Instrumentation::Call call(env, JNIFunction::DeleteWeakGlobalRef);
+        ReferenceTracking::Deleted(ReferenceKind::WeakGlobal, ref.get());
         env.DeleteWeakGlobalRef(Unwrap(ref.release()));
         CheckJavaException(env);
        }
@@ -227,31 +294,36 @@ namespace jni
 
     inline bool IsSameObject(JNIEnv& env, jobject* ref1, jobject* ref2)
        {
+        Instrumentation::Call call(env, JNIFunction::IsSameObject);
         return CheckJavaException(env,
             env.IsSameObject(Unwrap(ref1), Unwrap(ref2)));
        }
 
     inline jobject& AllocObject(JNIEnv& env, jclass& clazz)
        {
+        Instrumentation::Call call(env, JNIFunction::AllocObject);
         return *CheckJavaException(env,
-            Wrap<jobject*>(env.AllocObject(Unwrap(clazz))));
+            TrackLocal(JNIFunction::AllocObject, Wrap<jobject*>(env.AllocObject(Unwrap(clazz)))));
        }
 
     template < class... Args >
     jobject& NewObject(JNIEnv& env, jclass& clazz, jmethodID& method, Args&&... args)
        {
+        Instrumentation::Call call(env, JNIFunction::NewObject);
         return *CheckJavaException(env,
-            Wrap<jobject*>(env.NewObject(Unwrap(clazz), Unwrap(method), Unwrap(std::forward<Args>(args))...)));
+            TrackLocal(JNIFunction::NewObject, Wrap<jobject*>(env.NewObject(Unwrap(clazz), Unwrap(method), Unwrap(std::forward<Args>(args))...))));
        }
 
     inline jclass& GetObjectClass(JNIEnv& env, jobject& obj)
        {
+        Instrumentation::Call call(env, JNIFunction::GetObjectClass);
         return *CheckJavaException(env,
-            Wrap<jclass*>(env.GetObjectClass(Unwrap(obj))));
+            TrackLocal(JNIFunction::GetObjectClass, Wrap<jclass*>(env.GetObjectClass(Unwrap(obj)))));
        }
 
     inline bool IsInstanceOf(JNIEnv& env, jobject* obj, jclass& clazz)
        {
+        Instrumentation::Call call(env, JNIFunction::IsInstanceOf);
         return CheckJavaException(env,
             env.IsInstanceOf(Unwrap(obj), Unwrap(clazz))) == JNI_TRUE;
        }
@@ -259,6 +331,7 @@ namespace jni
 
     inline jmethodID& GetMethodID(JNIEnv& env, jclass& clazz, const char* name, const char* sig)
        {
+        Instrumentation::Call call(env, JNIFunction::GetMethodID);
         return *CheckJavaException(env,
             Wrap<jmethodID*>(env.GetMethodID(Unwrap(clazz), name, sig)));
        }
@@ -267,14 +340,16 @@ namespace jni
     std::enable_if_t<!std::is_void<R>::value, R>
     CallMethod(JNIEnv& env, jobject* obj, jmethodID& method, Args&&... args)
        {
+        Instrumentation::Call call(env, JNIFunction::CallMethod);
         return CheckJavaException(env,
-            Wrap<R>((env.*(TypedMethods<R>::CallMethod))(Unwrap(obj), Unwrap(method), Unwrap(std::forward<Args>(args))...)));
+            TrackLocal(JNIFunction::CallMethod, Wrap<R>((env.*(TypedMethods<R>::CallMethod))(Unwrap(obj), Unwrap(method), Unwrap(std::forward<Args>(args))...))));
        }
 
     template < class R, class... Args >
     std::enable_if_t<std::is_void<R>::value, R>
     CallMethod(JNIEnv& env, jobject* obj, jmethodID& method, Args&&... args)
        {
+        Instrumentation::Call call(env, JNIFunction::CallMethod);
         env.CallVoidMethod(Unwrap(obj), Unwrap(method), Unwrap(std::forward<Args>(args))...);
         CheckJavaException(env);
        }
@@ -283,14 +358,16 @@ namespace jni
     std::enable_if_t<!std::is_void<R>::value, R>
     CallNonvirtualMethod(JNIEnv& env, jobject* obj, jclass& clazz, jmethodID& method, Args&&... args)
        {
+        Instrumentation::Call call(env, JNIFunction::CallNonvirtualMethod);
         return CheckJavaException(env,
-            Wrap<R>((env.*(TypedMethods<R>::CallNonvirtualMethod))(Unwrap(obj), Unwrap(clazz), Unwrap(method), Unwrap(std::forward<Args>(args))...)));
+            TrackLocal(JNIFunction::CallNonvirtualMethod, Wrap<R>((env.*(TypedMethods<R>::CallNonvirtualMethod))(Unwrap(obj), Unwrap(clazz), Unwrap(method), Unwrap(std::forward<Args>(args))...))));
        }
 
     template < class R, class... Args >
     std::enable_if_t<std::is_void<R>::value, R>
     CallNonvirtualMethod(JNIEnv& env, jobject* obj, jclass& clazz, jmethodID& method, Args&&... args)
        {
+        Instrumentation::Call call(env, JNIFunction::CallNonvirtualMethod);
         env.CallNonvirtualVoidMethod(Unwrap(obj), Unwrap(clazz), Unwrap(method), Unwrap(std::forward<Args>(args))...);
         CheckJavaException(env);
        }
@@ -298,6 +375,7 @@ namespace jni
 
     inline jfieldID& GetFieldID(JNIEnv& env, jclass& clazz, const char* name, const char* sig)
        {
+        Instrumentation::Call call(env, JNIFunction::GetFieldID);
         return *CheckJavaException(env,
             Wrap<jfieldID*>(env.GetFieldID(Unwrap(clazz), name, sig)));
        }
@@ -305,13 +383,15 @@ namespace jni
     template < class T >
     T GetField(JNIEnv& env, jobject* obj, jfieldID& field)
        {
+        Instrumentation::Call call(env, JNIFunction::GetField);
         return CheckJavaException(env,
-            Wrap<T>((env.*(TypedMethods<T>::GetField))(Unwrap(obj), Unwrap(field))));
+            TrackLocal(JNIFunction::GetField, Wrap<T>((env.*(TypedMethods<T>::GetField))(Unwrap(obj), Unwrap(field)))));
        }
 
     template < class T >
     void SetField(JNIEnv& env, jobject* obj, jfieldID& field, T value)
        {
+        Instrumentation::Call call(env, JNIFunction::SetField);
         (env.*(TypedMethods<T>::SetField))(Unwrap(obj), Unwrap(field), Unwrap(value));
         CheckJavaException(env);
        }
@@ -319,6 +399,7 @@ namespace jni
 
     inline jmethodID& GetStaticMethodID(JNIEnv& env, jclass& clazz, const char* name, const char* sig)
        {
+        Instrumentation::Call call(env, JNIFunction::GetStaticMethodID);
         return *CheckJavaException(env,
             Wrap<jmethodID*>(env.GetStaticMethodID(Unwrap(clazz), name, sig)));
        }
@@ -327,14 +408,16 @@ namespace jni
     std::enable_if_t<!std::is_void<R>::value, R>
     CallStaticMethod(JNIEnv& env, jclass& clazz, jmethodID& method, Args&&... args)
        {
+        Instrumentation::Call call(env, JNIFunction::CallStaticMethod);
         return CheckJavaException(env,
-            Wrap<R>((env.*(TypedMethods<R>::CallStaticMethod))(Unwrap(clazz), Unwrap(method), Unwrap(std::forward<Args>(args))...)));
+            TrackLocal(JNIFunction::CallStaticMethod, Wrap<R>((env.*(TypedMethods<R>::CallStaticMethod))(Unwrap(clazz), Unwrap(method), Unwrap(std::forward<Args>(args))...))));
        }
 
     template < class R, class... Args >
     std::enable_if_t<std::is_void<R>::value, R>
     CallStaticMethod(JNIEnv& env, jclass& clazz, jmethodID& method, Args&&... args)
        {
+        Instrumentation::Call call(env, JNIFunction::CallStaticMethod);
         env.CallStaticVoidMethod(Unwrap(clazz), Unwrap(method), Unwrap(std::forward<Args>(args))...);
         CheckJavaException(env);
        }
@@ -342,6 +425,7 @@ namespace jni
 
     inline jfieldID& GetStaticFieldID(JNIEnv& env, jclass& clazz, const char* name, const char* sig)
        {
+        Instrumentation::Call call(env, JNIFunction::GetStaticFieldID);
         return *CheckJavaException(env,
             Wrap<jfieldID*>(env.GetStaticFieldID(Unwrap(clazz), name, sig)));
        }
@@ -349,13 +433,15 @@ namespace jni
     template < class T >
     T GetStaticField(JNIEnv& env, jclass& clazz, jfieldID& field)
        {
+        Instrumentation::Call call(env, JNIFunction::GetStaticField);
         return CheckJavaException(env,
-            Wrap<T>((env.*(TypedMethods<T>::GetStaticField))(Unwrap(clazz), Unwrap(field))));
+            TrackLocal(JNIFunction::GetStaticField, Wrap<T>((env.*(TypedMethods<T>::GetStaticField))(Unwrap(clazz), Unwrap(field)))));
        }
 
     template < class T >
     void SetStaticField(JNIEnv& env, jclass& clazz, jfieldID& field, T value)
        {
+        Instrumentation::Call call(env, JNIFunction::SetStaticField);
         (env.*(TypedMethods<T>::SetStaticField))(Unwrap(clazz), Unwrap(field), Unwrap(value));
         CheckJavaException(env);
        }
@@ -363,8 +449,9 @@ namespace jni
 
     inline jstring& NewString(JNIEnv& env, const char16_t* chars, jsize len)
        {
+        Instrumentation::Call call(env, JNIFunction::NewString);
         return *CheckJavaException(env,
-            Wrap<jstring*>(env.NewString(Unwrap(chars), Unwrap(len))));
+            TrackLocal(JNIFunction::NewString, Wrap<jstring*>(env.NewString(Unwrap(chars), Unwrap(len)))));
        }
 
     template < class Array >
@@ -376,12 +463,14 @@ namespace jni
 
     inline jsize GetStringLength(JNIEnv& env, jstring& string)
        {
+        Instrumentation::Call call(env, JNIFunction::GetStringLength);
         return CheckJavaException(env,
             Wrap<jsize>(env.GetStringLength(Unwrap(string))));
        }
 
     inline std::tuple<UniqueStringChars, bool> GetStringChars(JNIEnv& env, jstring& string)
        {
+        Instrumentation::Call call(env, JNIFunction::GetStringChars);
         ::jboolean isCopy = JNI_FALSE;
         const char16_t* result = CheckJavaException(env,
             Wrap<const char16_t*>(env.GetStringChars(Unwrap(string), &isCopy)));
@@ -390,24 +479,28 @@ namespace jni
 
     inline void ReleaseStringChars(JNIEnv& env, jstring& string, UniqueStringChars&& chars)
        {
+        Instrumentation::Call call(env, JNIFunction::ReleaseStringChars);
         env.ReleaseStringChars(Unwrap(string), Unwrap(chars.release()));
         CheckJavaException(env);
        }
 
     inline jstring& NewStringUTF(JNIEnv& env, const char* bytes)
        {
+        Instrumentation::Call call(env, JNIFunction::NewStringUTF);
         return *CheckJavaException(env,
-            Wrap<jstring*>(env.NewStringUTF(bytes)));
+            TrackLocal(JNIFunction::NewStringUTF, Wrap<jstring*>(env.NewStringUTF(bytes))));
        }
 
     inline jsize GetStringUTFLength(JNIEnv& env, jstring& string)
        {
+        Instrumentation::Call call(env, JNIFunction::GetStringUTFLength);
         return CheckJavaException(env,
             Wrap<jsize>(env.GetStringUTFLength(Unwrap(string))));
        }
 
     inline std::tuple<UniqueStringUTFChars, bool> GetStringUTFChars(JNIEnv& env, jstring& string)
        {
+        Instrumentation::Call call(env, JNIFunction::GetStringUTFChars);
         ::jboolean isCopy = JNI_FALSE;
         const char* result = CheckJavaException(env,
             env.GetStringUTFChars(Unwrap(string), &isCopy));
@@ -416,38 +509,42 @@ namespace jni
 
     inline void ReleaseStringUTFChars(JNIEnv& env, jstring& string, UniqueStringUTFChars&& chars)
        {
+        Instrumentation::Call call(env, JNIFunction::ReleaseStringUTFChars);
         env.ReleaseStringUTFChars(Unwrap(string), chars.release());
         CheckJavaException(env);
        }
 
     inline void GetStringRegion(JNIEnv& env, jstring& string, jsize start, jsize len, char16_t* buf)
        {
+        Instrumentation::Call call(env, JNIFunction::GetStringRegion);
         env.GetStringRegion(Unwrap(string), Unwrap(start), Unwrap(len), Unwrap(buf));
         CheckJavaException(env);
        }
 
     template < class Array >
-    auto GetStringRegion(JNIEnv& env, jstring& string, jsize start, Array& buf)
-       -> std::enable_if_t< IsArraylike<Array>::value >
+    auto GetStringRegion(JNIEnv& env, jstring& string, jsize start, Array&& buf)
+       -> std::enable_if_t< IsArraylike<std::remove_cv_t<std::remove_reference_t<Array>>>::value >
        {
         GetStringRegion(env, string, start, ArraylikeSize(buf), ArraylikeData(buf));
        }
 
     inline void GetStringUTFRegion(JNIEnv& env, jstring& string, jsize start, jsize len, char* buf)
        {
+        Instrumentation::Call call(env, JNIFunction::GetStringUTFRegion);
         env.GetStringUTFRegion(Unwrap(string), Unwrap(start), Unwrap(len), buf);
         CheckJavaException(env);
        }
 
     template < class Array >
-    auto GetStringUTFRegion(JNIEnv& env, jstring& string, jsize start, Array& buf)
-       -> std::enable_if_t< IsArraylike<Array>::value >
+    auto GetStringUTFRegion(JNIEnv& env, jstring& string, jsize start, Array&& buf)
+       -> std::enable_if_t< IsArraylike<std::remove_cv_t<std::remove_reference_t<Array>>>::value >
        {
         GetStringUTFRegion(env, string, start, ArraylikeSize(buf), ArraylikeData(buf));
        }
 
     inline std::tuple<UniqueStringCritical, bool> GetStringCritical(JNIEnv& env, jstring& string)
        {
+        Instrumentation::Call call(env, JNIFunction::GetStringCritical);
         ::jboolean isCopy = JNI_FALSE;
         const char16_t* result = CheckJavaException(env,
             Wrap<const char16_t*>(env.GetStringCritical(Unwrap(string), &isCopy)));
@@ -456,6 +553,7 @@ namespace jni
 
     inline void ReleaseStringCritical(JNIEnv& env, jstring& string, UniqueStringCritical&& chars)
        {
+        Instrumentation::Call call(env, JNIFunction::ReleaseStringCritical);
         env.ReleaseStringCritical(Unwrap(string), Unwrap(chars.release()));
         CheckJavaException(env);
        }
@@ -464,6 +562,7 @@ namespace jni
     template < class E >
     jsize GetArrayLength(JNIEnv& env, jarray<E>& array)
        {
+        Instrumentation::Call call(env, JNIFunction::GetArrayLength);
         return CheckJavaException(env,
             Wrap<jsize>(env.GetArrayLength(Unwrap(array))));
        }
@@ -471,13 +570,15 @@ namespace jni
     template < class E >
     jarray<E>& NewArray(JNIEnv& env, jsize length)
        {
+        Instrumentation::Call call(env, JNIFunction::NewArray);
         return *CheckJavaException(env,
-            Wrap<jarray<E>*>((env.*(TypedMethods<E>::NewArray))(Unwrap(length))));
+            TrackLocal(JNIFunction::NewArray, Wrap<jarray<E>*>((env.*(TypedMethods<E>::NewArray))(Unwrap(length)))));
        }
 
     template < class E >
     std::tuple<UniqueArrayElements<E>, bool> GetArrayElements(JNIEnv& env, jarray<E>& array)
        {
+        Instrumentation::Call call(env, JNIFunction::GetArrayElements);
         ::jboolean isCopy = JNI_FALSE;
         E* result = CheckJavaException(env,
             (env.*(TypedMethods<E>::GetArrayElements))(Unwrap(array), &isCopy));
@@ -487,6 +588,7 @@ namespace jni
     template < class E >
     void ReleaseArrayElements(JNIEnv& env, jarray<E>& array, E* elems)
        {
+        Instrumentation::Call call(env, JNIFunction::ReleaseArrayElements);
         (env.*(TypedMethods<E>::ReleaseArrayElements))(Unwrap(array), elems, JNI_COMMIT);
         CheckJavaException(env);
        }
@@ -494,6 +596,7 @@ namespace jni
     template < class E >
     void ReleaseArrayElements(JNIEnv& env, jarray<E>& array, UniqueArrayElements<E>&& elems)
        {
+        Instrumentation::Call call(env, JNIFunction::ReleaseArrayElements);
         (env.*(TypedMethods<E>::ReleaseArrayElements))(Unwrap(array), elems.release(), 0);
         CheckJavaException(env);
        }
@@ -501,6 +604,7 @@ namespace jni
     template < class E >
     std::tuple<UniquePrimitiveArrayCritical<E>, bool> GetPrimitiveArrayCritical(JNIEnv& env, jarray<E>& array)
        {
+        Instrumentation::Call call(env, JNIFunction::GetPrimitiveArrayCritical);
         ::jboolean isCopy = JNI_FALSE;
         void* result = CheckJavaException(env,
             env.GetPrimitiveArrayCritical(Unwrap(array), &isCopy));
@@ -510,6 +614,7 @@ namespace jni
     template < class E >
     void ReleasePrimitiveArrayCritical(JNIEnv& env, jarray<E>& array, void* carray)
        {
+        Instrumentation::Call call(env, JNIFunction::ReleasePrimitiveArrayCritical);
         env.ReleasePrimitiveArrayCritical(Unwrap(array), carray, 0);
         CheckJavaException(env);
        }
@@ -517,6 +622,7 @@ namespace jni
     template < class E >
     void ReleasePrimitiveArrayCritical(JNIEnv& env, jarray<E>& array, UniquePrimitiveArrayCritical<E>&& carray)
        {
+        Instrumentation::Call call(env, JNIFunction::ReleasePrimitiveArrayCritical);
         env.ReleasePrimitiveArrayCritical(Unwrap(array), carray.release(), JNI_COMMIT);
         CheckJavaException(env);
        }
@@ -524,13 +630,14 @@ namespace jni
     template < class T >
     void GetArrayRegion(JNIEnv& env, jarray<T>& array, jsize start, jsize len, T* buf)
        {
+        Instrumentation::Call call(env, JNIFunction::GetArrayRegion);
         (env.*(TypedMethods<T>::GetArrayRegion))(Unwrap(array), Unwrap(start), Unwrap(len), buf);
         CheckJavaException(env);
        }
 
     template < class T, class Array >
-    auto GetArrayRegion(JNIEnv& env, jarray<T>& array, jsize start, Array& buf)
-       -> std::enable_if_t< IsArraylike<Array>::value >
+    auto GetArrayRegion(JNIEnv& env, jarray<T>& array, jsize start, Array&& buf)
+       -> std::enable_if_t< IsArraylike<std::remove_cv_t<std::remove_reference_t<Array>>>::value >
        {
         GetArrayRegion(env, array, start, ArraylikeSize(buf), ArraylikeData(buf));
        }
@@ -538,6 +645,7 @@ namespace jni
     template < class T >
     void SetArrayRegion(JNIEnv& env, jarray<T>& array, jsize start, jsize len, const T* buf)
        {
+        Instrumentation::Call call(env, JNIFunction::SetArrayRegion);
         (env.*(TypedMethods<T>::SetArrayRegion))(Unwrap(array), Unwrap(start), Unwrap(len), buf);
         CheckJavaException(env);
        }
@@ -552,18 +660,21 @@ namespace jni
 
     inline jarray<jobject>& NewObjectArray(JNIEnv& env, jsize length, jclass& elementClass, jobject* initialElement = nullptr)
        {
+        Instrumentation::Call call(env, JNIFunction::NewObjectArray);
         return *CheckJavaException(env,
-            Wrap<jarray<jobject>*>(env.NewObjectArray(Unwrap(length), Unwrap(elementClass), Unwrap(initialElement))));
+            TrackLocal(JNIFunction::NewObjectArray, Wrap<jarray<jobject>*>(env.NewObjectArray(Unwrap(length), Unwrap(elementClass), Unwrap(initialElement)))));
        }
 
     inline jobject* GetObjectArrayElement(JNIEnv& env, jarray<jobject>& array, jsize index)
        {
+        Instrumentation::Call call(env, JNIFunction::GetObjectArrayElement);
         return CheckJavaException(env,
-            Wrap<jobject*>(env.GetObjectArrayElement(Unwrap(array), Unwrap(index))));
+            TrackLocal(JNIFunction::GetObjectArrayElement, Wrap<jobject*>(env.GetObjectArrayElement(Unwrap(array), Unwrap(index)))));
        }
 
     inline void SetObjectArrayElement(JNIEnv& env, jarray<jobject>& array, jsize index, jobject* value)
        {
+        Instrumentation::Call call(env, JNIFunction::SetObjectArrayElement);
         env.SetObjectArrayElement(Unwrap(array), Unwrap(index), Unwrap(value));
         CheckJavaException(env);
        }
@@ -572,6 +683,7 @@ namespace jni
     template < class... Methods >
     inline void RegisterNatives(JNIEnv& env, jclass& clazz, const Methods&... methods)
        {
+        Instrumentation::Call call(env, JNIFunction::RegisterNatives);
         ::JNINativeMethod unwrapped[sizeof...(methods)] = { Unwrap(methods)... };
         CheckJavaExceptionThenErrorCode(env,
             env.RegisterNatives(Unwrap(clazz), unwrapped, sizeof...(methods)));
@@ -579,24 +691,28 @@ namespace jni
 
     inline void UnregisterNatives(JNIEnv& env, jclass& clazz)
        {
+        Instrumentation::Call call(env, JNIFunction::UnregisterNatives);
         CheckJavaExceptionThenErrorCode(env, env.UnregisterNatives(Unwrap(clazz)));
        }
 
 
     inline UniqueMonitor MonitorEnter(JNIEnv& env, jobject* obj)
        {
+        Instrumentation::Call call(env, JNIFunction::MonitorEnter);
         CheckJavaExceptionThenErrorCode(env, env.MonitorEnter(Unwrap(obj)));
         return UniqueMonitor(obj, MonitorDeleter(env));
        }
 
     inline void MonitorExit(JNIEnv& env, UniqueMonitor&& monitor)
        {
+        Instrumentation::Call call(env, JNIFunction::MonitorExit);
         CheckJavaExceptionThenErrorCode(env, env.MonitorExit(Unwrap(monitor.release())));
        }
 
 
     inline JavaVM& GetJavaVM(JNIEnv& env)
        {
+        Instrumentation::Call call(env, JNIFunction::GetJavaVM);
         JavaVM* result = nullptr;
         CheckJavaExceptionThenErrorCode(env, env.GetJavaVM(&result));
         return *result;
@@ -605,18 +721,21 @@ namespace jni
 
     inline jobject& NewDirectByteBuffer(JNIEnv& env, void* address, jlong capacity)
        {
+        Instrumentation::Call call(env, JNIFunction::NewDirectByteBuffer);
         return *CheckJavaException(env,
-            Wrap<jobject*>(env.NewDirectByteBuffer(address, Unwrap(capacity))));
+            TrackLocal(JNIFunction::NewDirectByteBuffer, Wrap<jobject*>(env.NewDirectByteBuffer(address, Unwrap(capacity)))));
        }
 
     inline void* GetDirectBufferAddress(JNIEnv& env, jobject& buf)
        {
+        Instrumentation::Call call(env, JNIFunction::GetDirectBufferAddress);
         return CheckJavaException(env,
             env.GetDirectBufferAddress(Unwrap(buf)));
        }
 
     inline jlong GetDirectBufferCapacity(JNIEnv& env, jobject& buf)
        {
+        Instrumentation::Call call(env, JNIFunction::GetDirectBufferCapacity);
         return CheckJavaException(env,
             env.GetDirectBufferCapacity(Unwrap(buf)));
        }
@@ -624,6 +743,7 @@ namespace jni
 
     inline jobjectRefType GetObjectRefType(JNIEnv& env, jobject* obj)
        {
+        Instrumentation::Call call(env, JNIFunction::GetObjectRefType);
         return env.GetObjectRefType(Unwrap(obj));
        }
 
@@ -0,0 +1,285 @@
+#pragma once
+
+#include <jni/functions.hpp>
+#include <jni/tagging.hpp>
+#include <jni/class.hpp>
+#include <jni/object.hpp>
+#include <jni/array.hpp>
+#include <jni/unique.hpp>
+#include <jni/advanced_ownership.hpp>
+
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace jni
+   {
+    /*
+        A pool of strong references to Java objects, held as elements of Java `Object[]` arrays
+        ("segments") rather than as individual global references. Each segment is itself held by a
+        single global reference, so that adding and removing objects costs an array store and a
+        short critical section on one of the pool's free lists, rather than a NewGlobalRef /
+        DeleteGlobalRef pair, which on HotSpot take a JVM-wide lock. Reading an object takes no
+        lock. Use it for large numbers of short-lived strong references, such as registered
+        callbacks.
+
+        `Add` returns a move-only `Handle`, which removes the object from the pool when destroyed.
+        Like `Global<T>` with DefaultRefDeleter, a handle uses the JNIEnv passed to `Add` for
+        removal; when removing on a different thread, use `reset(env)`. The pool must outlive its
+        handles.
+
+        Segments of `elementsPerSegment` elements are allocated as needed, up to `segmentLimit`;
+        beyond that, `Add` throws std::bad_alloc. Segments are not released until the pool is
+        destroyed. All member functions may be called concurrently from any attached thread.
+    */
+    template < class T = Object<> >
+    class GlobalRefPool
+       {
+        private:
+            using Segment = Global<Array<Object<>>, EnvAttachingDeleter>;
+
+            // Free slots are kept in several lists, each with its own lock, and each thread uses
+            // the list selected by its thread ID, so that threads rarely contend. A thread whose
+            // list is empty takes half of another's before allocating a segment, so that slots
+            // freed on one thread are reused when objects are added on another.
+            struct Shard
+               {
+                std::mutex mutex;
+                std::vector<std::size_t> free;
+                char padding[64]; // Keeps shards' locks on separate cache lines.
+               };
+
+            static constexpr std::size_t shardCount = 16;
+
+            const std::size_t segmentSize;
+            const std::size_t maxSegments;
+            const std::unique_ptr<Segment[]> segments;
+
+            std::array<Shard, shardCount> shards;
+            std::mutex segmentMutex;
+            std::size_t segmentCount = 0;
+            std::atomic<std::size_t> size { 0 };
+
+            Shard& OwnShard()
+               {
+                static thread_local const std::size_t index =
+                    std::hash<std::thread::id>()(std::this_thread::get_id()) % shardCount;
+                return shards[index];
+               }
+
+            jarray<jobject>& SegmentArray(JNIEnv& env, std::size_t index) const
+               {
+                return SafeDereference(env, segments[index / segmentSize].get());
+               }
+
+            // Requires the shard lock. Returns false if the segment limit has been reached.
+            bool Grow(JNIEnv& env, Shard& shard)
+               {
+                std::lock_guard<std::mutex> lock(segmentMutex);
+                if (segmentCount == maxSegments)
+                    return false;
+
+                segments[segmentCount] = NewGlobal<EnvAttachingDeleter>(env, Array<Object<>>::New(env, segmentSize));
+
+                // Hand out the lowest indices first.
+                for (std::size_t i = segmentSize; i > 0; --i)
+                    shard.free.push_back(segmentCount * segmentSize + i - 1);
+                ++segmentCount;
+                return true;
+               }
+
+            // Requires the shard lock.
+            static bool Pop(Shard& shard, std::size_t& index)
+               {
+                if (shard.free.empty())
+                    return false;
+                index = shard.free.back();
+                shard.free.pop_back();
+                return true;
+               }
+
+            // Moves half of the free slots of another shard, if any has some, to `own`. Locks one
+            // shard at a time.
+            void Steal(Shard& own)
+               {
+                std::vector<std::size_t> stolen;
+
+                for (Shard& shard : shards)
+                   {
+                    if (&shard == &own)
+                        continue;
+
+                    std::lock_guard<std::mutex> lock(shard.mutex);
+                    if (shard.free.empty())
+                        continue;
+
+                    const auto half = shard.free.end() - static_cast<std::ptrdiff_t>((shard.free.size() + 1) / 2);
+                    stolen.assign(half, shard.free.end());
+                    shard.free.erase(half, shard.free.end());
+                    break;
+                   }
+
+                if (stolen.empty())
+                    return;
+
+                std::lock_guard<std::mutex> lock(own.mutex);
+                own.free.insert(own.free.end(), stolen.begin(), stolen.end());
+               }
+
+            std::size_t Acquire(JNIEnv& env)
+               {
+                std::size_t index = 0;
+                Shard& own = OwnShard();
+
+                   {
+                    std::lock_guard<std::mutex> lock(own.mutex);
+                    if (Pop(own, index))
+                       {
+                        ++size;
+                        return index;
+                       }
+                   }
+
+                Steal(own);
+
+                std::lock_guard<std::mutex> lock(own.mutex);
+                if (Pop(own, index) || (Grow(env, own) && Pop(own, index)))
+                   {
+                    ++size;
+                    return index;
+                   }
+
+                throw std::bad_alloc();
+               }
+
+            void Free(std::size_t index)
+               {
+                Shard& own = OwnShard();
+                std::lock_guard<std::mutex> lock(own.mutex);
+                own.free.push_back(index);
+                --size;
+               }
+
+            // Called from Handle destructors, so does not throw.
+            void Release(JNIEnv& env, std::size_t index)
+               {
+                Instrumentation::Call call(env, JNIFunction::SetObjectArrayElement);
+                env.SetObjectArrayElement(Unwrap(SegmentArray(env, index)), static_cast<::jsize>(index % segmentSize), nullptr);
+                Free(index);
+               }
+
+        public:
+            class Handle
+               {
+                private:
+                    friend class GlobalRefPool;
+
+                    GlobalRefPool* pool = nullptr;
+                    JNIEnv* env = nullptr;
+                    std::size_t index = 0;
+
+                    Handle(GlobalRefPool& p, JNIEnv& e, std::size_t i)
+                       : pool(&p), env(&e), index(i) {}
+
+                public:
+                    Handle() = default;
+
+                    Handle(Handle&& other)
+                       : pool(std::exchange(other.pool, nullptr)), env(other.env), index(other.index) {}
+
+                    Handle& operator=(Handle&& other)
+                       {
+                        reset();
+                        pool = std::exchange(other.pool, nullptr);
+                        env = other.env;
+                        index = other.index;
+                        return *this;
+                       }
+
+                    Handle(const Handle&) = delete;
+                    Handle& operator=(const Handle&) = delete;
+
+                    ~Handle()
+                       {
+                        reset();
+                       }
+
+                    explicit operator bool() const
+                       {
+                        return pool != nullptr;
+                       }
+
+                    Local<T> Get(JNIEnv& e) const
+                       {
+                        assert(pool);
+                        return Local<T>(e,
+                            reinterpret_cast<typename T::UntaggedType*>(
+                                GetObjectArrayElement(e, pool->SegmentArray(e, index), index % pool->segmentSize)));
+                       }
+
+                    void reset()
+                       {
+                        if (pool)
+                           {
+                            assert(env);
+                            reset(*env);
+                           }
+                       }
+
+                    void reset(JNIEnv& e)
+                       {
+                        if (pool)
+                           {
+                            std::exchange(pool, nullptr)->Release(e, index);
+                           }
+                       }
+               };
+
+            explicit GlobalRefPool(std::size_t elementsPerSegment = 1024, std::size_t segmentLimit = 1024)
+               : segmentSize(elementsPerSegment),
+                 maxSegments(segmentLimit),
+                 segments(new Segment[segmentLimit])
+               {
+                assert(segmentSize > 0);
+               }
+
+            GlobalRefPool(const GlobalRefPool&) = delete;
+            GlobalRefPool& operator=(const GlobalRefPool&) = delete;
+
+            Handle Add(JNIEnv& env, const T& object)
+               {
+                const std::size_t index = Acquire(env);
+                try
+                   {
+                    SetObjectArrayElement(env, SegmentArray(env, index), index % segmentSize, object.get());
+                   }
+                catch (...)
+                   {
+                    Free(index);
+                    throw;
+                   }
+                return Handle(*this, env, index);
+               }
+
+            // The number of objects currently in the pool.
+            std::size_t Size() const
+               {
+                return size.load();
+               }
+
+            // The number of objects the allocated segments can hold.
+            std::size_t Capacity()
+               {
+                std::lock_guard<std::mutex> lock(segmentMutex);
+                return segmentCount * segmentSize;
+               }
+       };
+   }
@@ -0,0 +1,287 @@
+#pragma once
+
+#include <jni/functions.hpp>
+#include <jni/object.hpp>
+#include <jni/unique.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace jni
+   {
+    /*
+        A thread-safe table of global and weak global references, addressed by 64-bit handles, for
+        native code that refers to many Java objects across threads (for instance, subscribers).
+
+        A handle combines a slot index with the slot's generation, which is incremented when the
+        slot is freed, so a stale handle is never confused with a later entry in the same slot. The
+        value 0 is never a valid handle.
+
+        The table is divided into shards, each with a reader-writer lock; lookups take only a
+        shared lock on one shard. (They cannot be entirely lock-free: a lookup promotes the stored
+        reference to a local reference, and must exclude a concurrent removal that deletes it.)
+        References are deleted after the shard lock is released, and `Remove` and `SweepWeak`
+        delete in batches using a single JNIEnv.
+
+        References remaining when the table is destroyed are deleted using an attached JNIEnv,
+        attaching the current thread if necessary.
+    */
+    template < class T = Object<> >
+    class HandleTable
+       {
+        public:
+            using Handle = std::uint64_t;
+
+        private:
+            struct Entry
+               {
+                jobject* reference = nullptr;
+                std::uint32_t generation = 1;
+                bool weak = false;
+               };
+
+            struct Shard
+               {
+                mutable std::shared_timed_mutex mutex;
+                std::vector<Entry> entries;
+                std::vector<std::uint32_t> free;
+               };
+
+            struct Removed
+               {
+                jobject* reference;
+                bool weak;
+               };
+
+            static constexpr std::uint32_t shardCount = 16;
+
+            JavaVM* vm;
+            std::array<Shard, shardCount> shards;
+            std::atomic<std::size_t> size { 0 };
+
+            static Handle MakeHandle(std::uint32_t shard, std::uint32_t index, std::uint32_t generation)
+               {
+                return (Handle(generation) << 32) | (Handle(index) * shardCount + shard);
+               }
+
+            static std::uint32_t ShardOf(Handle handle)   { return std::uint32_t(handle & 0xFFFFFFFF) % shardCount; }
+            static std::uint32_t IndexOf(Handle handle)   { return std::uint32_t(handle & 0xFFFFFFFF) / shardCount; }
+            static std::uint32_t GenerationOf(Handle handle) { return std::uint32_t(handle >> 32); }
+
+            // Requires a lock on the shard. Returns null if the handle is stale.
+            static const Entry* Find(const Shard& shard, Handle handle)
+               {
+                const std::uint32_t index = IndexOf(handle);
+                if (index >= shard.entries.size())
+                    return nullptr;
+                const Entry& entry = shard.entries[index];
+                if (!entry.reference || entry.generation != GenerationOf(handle))
+                    return nullptr;
+                return &entry;
+               }
+
+            // Requires an exclusive lock on the shard.
+            static Removed Free(Shard& shard, std::uint32_t index)
+               {
+                Entry& entry = shard.entries[index];
+                Removed removed { entry.reference, entry.weak };
+                entry.reference = nullptr;
+                if (++entry.generation == 0)
+                    entry.generation = 1;
+                shard.free.push_back(index);
+                return removed;
+               }
+
+            static void Delete(JNIEnv& env, const std::vector<Removed>& removed)
+               {
+                for (const Removed& r : removed)
+                   {
+                    if (r.weak)
+                       {
+                        ReferenceTracking::Deleted(ReferenceKind::WeakGlobal, r.reference);
+                        Instrumentation::Call call(env, JNIFunction::DeleteWeakGlobalRef);
+                        env.DeleteWeakGlobalRef(Unwrap(r.reference));
+                       }
+                    else
+                       {
+                        ReferenceTracking::Deleted(ReferenceKind::Global, r.reference);
+                        Instrumentation::Call call(env, JNIFunction::DeleteGlobalRef);
+                        env.DeleteGlobalRef(Unwrap(r.reference));
+                       }
+                   }
+               }
+
+            Handle Insert(jobject* reference, bool weak)
+               {
+                static thread_local const std::uint32_t s = std::uint32_t(std::hash<std::thread::id>()(std::this_thread::get_id()) % shardCount);
+                Shard& shard = shards[s];
+
+                std::lock_guard<std::shared_timed_mutex> lock(shard.mutex);
+
+                std::uint32_t index;
+                if (shard.free.empty())
+                   {
+                    index = std::uint32_t(shard.entries.size());
+                    shard.entries.emplace_back();
+                   }
+                else
+                   {
+                    index = shard.free.back();
+                    shard.free.pop_back();
+                   }
+
+                Entry& entry = shard.entries[index];
+                entry.reference = reference;
+                entry.weak = weak;
+                ++size;
+                return MakeHandle(s, index, entry.generation);
+               }
+
+        public:
+            explicit HandleTable(JNIEnv& env)
+               : vm(&GetJavaVM(env))
+               {}
+
+            HandleTable(const HandleTable&) = delete;
+            HandleTable& operator=(const HandleTable&) = delete;
+
+            ~HandleTable()
+               {
+                std::vector<Removed> removed;
+                for (Shard& shard : shards)
+                    for (const Entry& entry : shard.entries)
+                        if (entry.reference)
+                            removed.push_back({ entry.reference, entry.weak });
+
+                if (!removed.empty())
+                    Delete(*GetAttachedEnv(*vm), removed);
+               }
+
+            // Stores a new global reference to `object`.
+            Handle Add(JNIEnv& env, const T& object)
+               {
+                auto reference = NewGlobalRef(env, object.get());
+                const Handle handle = Insert(reference.get(), false);
+                reference.release();
+                return handle;
+               }
+
+            // Stores a new weak global reference to `object`.
+            Handle AddWeak(JNIEnv& env, const T& object)
+               {
+                auto reference = NewWeakGlobalRef(env, object.get());
+                const Handle handle = Insert(reference.get(), true);
+                reference.release();
+                return handle;
+               }
+
+            // Returns a local reference to the object, or an empty result if the handle has been
+            // removed, or refers to a weak reference whose object has been collected.
+            Local<T> Get(JNIEnv& env, Handle handle) const
+               {
+                const Shard& shard = shards[ShardOf(handle)];
+                std::shared_lock<std::shared_timed_mutex> lock(shard.mutex);
+
+                const Entry* entry = Find(shard, handle);
+                if (!entry)
+                    return Local<T>();
+
+                Instrumentation::Call call(env, JNIFunction::NewLocalRef);
+                jobject* obj = Wrap<jobject*>(env.NewLocalRef(Unwrap(entry->reference)));
+                ReferenceTracking::Created(ReferenceKind::Local, JNIFunction::NewLocalRef, obj);
+                CheckJavaException(env);
+                return Local<T>(env, reinterpret_cast<typename T::UntaggedType*>(obj));
+               }
+
+            bool Contains(Handle handle) const
+               {
+                const Shard& shard = shards[ShardOf(handle)];
+                std::shared_lock<std::shared_timed_mutex> lock(shard.mutex);
+                return Find(shard, handle) != nullptr;
+               }
+
+            // Removes the entry and deletes its reference. Returns false if the handle is stale.
+            bool Remove(JNIEnv& env, Handle handle)
+               {
+                return Remove(env, &handle, &handle + 1) == 1;
+               }
+
+            // Removes the entries for a range of handles, then deletes their references with `env`.
+            // Stale handles are ignored. Returns the number of entries removed.
+            template < class Iterator >
+            std::size_t Remove(JNIEnv& env, Iterator begin, Iterator end)
+               {
+                std::vector<Removed> removed;
+
+                for (Iterator it = begin; it != end; ++it)
+                   {
+                    const Handle handle = *it;
+                    Shard& shard = shards[ShardOf(handle)];
+                    std::lock_guard<std::shared_timed_mutex> lock(shard.mutex);
+                    if (Find(shard, handle))
+                        removed.push_back(Free(shard, IndexOf(handle)));
+                   }
+
+                size -= removed.size();
+                Delete(env, removed);
+                return removed.size();
+               }
+
+            // Removes all weak entries whose objects have been collected, and deletes their weak
+            // references with `env`. Returns the number of entries removed.
+            std::size_t SweepWeak(JNIEnv& env)
+               {
+                std::vector<Removed> removed;
+                std::vector<Handle> cleared;
+
+                for (std::uint32_t s = 0; s < shardCount; ++s)
+                   {
+                    Shard& shard = shards[s];
+                    cleared.clear();
+
+                    // Once cleared, a weak reference stays cleared, so candidates found under the
+                    // shared lock remain valid if their generation is unchanged.
+                       {
+                        std::shared_lock<std::shared_timed_mutex> lock(shard.mutex);
+                        for (std::uint32_t i = 0; i < shard.entries.size(); ++i)
+                           {
+                            const Entry& entry = shard.entries[i];
+                            if (!entry.reference || !entry.weak)
+                                continue;
+
+                            Instrumentation::Call call(env, JNIFunction::IsSameObject);
+                            if (env.IsSameObject(Unwrap(entry.reference), nullptr))
+                                cleared.push_back(MakeHandle(s, i, entry.generation));
+                           }
+                       }
+
+                    if (cleared.empty())
+                        continue;
+
+                    std::lock_guard<std::shared_timed_mutex> lock(shard.mutex);
+                    for (Handle handle : cleared)
+                        if (Find(shard, handle))
+                            removed.push_back(Free(shard, IndexOf(handle)));
+                   }
+
+                size -= removed.size();
+                Delete(env, removed);
+                return removed.size();
+               }
+
+            // The number of entries, including weak entries whose objects have been collected but
+            // which have not yet been swept.
+            std::size_t Size() const
+               {
+                return size.load();
+               }
+       };
+   }
@@ -0,0 +1,399 @@
+#pragma once
+
+#include <jni/types.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace jni
+   {
+    // Identifies the JNI function called by a wrapper in functions.hpp. Functions with one variant
+    // per type, such as Call<Type>Method, share an identifier.
+    enum class JNIFunction : std::size_t
+       {
+        GetVersion,
+        DefineClass,
+        FindClass,
+        FromReflectedMethod,
+        FromReflectedField,
+        ToReflectedMethod,
+        ToReflectedField,
+        GetSuperclass,
+        IsAssignableFrom,
+        Throw,
+        ThrowNew,
+        ExceptionCheck,
+        ExceptionOccurred,
+        ExceptionDescribe,
+        ExceptionClear,
+        FatalError,
+        PushLocalFrame,
+        PopLocalFrame,
+        NewGlobalRef,
+        DeleteGlobalRef,
+        NewLocalRef,
+        DeleteLocalRef,
+        EnsureLocalCapacity,
+        NewWeakGlobalRef,
+        DeleteWeakGlobalRef,
+        IsSameObject,
+        AllocObject,
+        NewObject,
+        GetObjectClass,
+        IsInstanceOf,
+        GetMethodID,
+        CallMethod,
+        CallNonvirtualMethod,
+        GetFieldID,
+        GetField,
+        SetField,
+        GetStaticMethodID,
+        CallStaticMethod,
+        GetStaticFieldID,
+        GetStaticField,
+        SetStaticField,
+        NewString,
+        GetStringLength,
+        GetStringChars,
+        ReleaseStringChars,
+        NewStringUTF,
+        GetStringUTFLength,
+        GetStringUTFChars,
+        ReleaseStringUTFChars,
+        GetStringRegion,
+        GetStringUTFRegion,
+        GetStringCritical,
+        ReleaseStringCritical,
+        GetArrayLength,
+        NewArray,
+        GetArrayElements,
+        ReleaseArrayElements,
+        GetPrimitiveArrayCritical,
+        ReleasePrimitiveArrayCritical,
+        GetArrayRegion,
+        SetArrayRegion,
+        NewObjectArray,
+        GetObjectArrayElement,
+        SetObjectArrayElement,
+        RegisterNatives,
+        UnregisterNatives,
+        MonitorEnter,
+        MonitorExit,
+        GetJavaVM,
+        NewDirectByteBuffer,
+        GetDirectBufferAddress,
+        GetDirectBufferCapacity,
+        GetObjectRefType
+       };
+
+    constexpr std::size_t jniFunctionCount = static_cast<std::size_t>(JNIFunction::GetObjectRefType) + 1;
+
+    inline const char* Name(JNIFunction function)
+       {
+        switch (function)
+           {
+            case JNIFunction::GetVersion:                     return "GetVersion";
+            case JNIFunction::DefineClass:                    return "DefineClass";
+            case JNIFunction::FindClass:                      return "FindClass";
+            case JNIFunction::FromReflectedMethod:            return "FromReflectedMethod";
+            case JNIFunction::FromReflectedField:             return "FromReflectedField";
+            case JNIFunction::ToReflectedMethod:              return "ToReflectedMethod";
+            case JNIFunction::ToReflectedField:               return "ToReflectedField";
+            case JNIFunction::GetSuperclass:                  return "GetSuperclass";
+            case JNIFunction::IsAssignableFrom:               return "IsAssignableFrom";
+            case JNIFunction::Throw:                          return "Throw";
+            case JNIFunction::ThrowNew:                       return "ThrowNew";
+            case JNIFunction::ExceptionCheck:                 return "ExceptionCheck";
+            case JNIFunction::ExceptionOccurred:              return "ExceptionOccurred";
+            case JNIFunction::ExceptionDescribe:              return "ExceptionDescribe";
+            case JNIFunction::ExceptionClear:                 return "ExceptionClear";
+            case JNIFunction::FatalError:                     return "FatalError";
+            case JNIFunction::PushLocalFrame:                 return "PushLocalFrame";
+            case JNIFunction::PopLocalFrame:                  return "PopLocalFrame";
+            case JNIFunction::NewGlobalRef:                   return "NewGlobalRef";
+            case JNIFunction::DeleteGlobalRef:                return "DeleteGlobalRef";
+            case JNIFunction::NewLocalRef:                    return "NewLocalRef";
+            case JNIFunction::DeleteLocalRef:                 return "DeleteLocalRef";
+            case JNIFunction::EnsureLocalCapacity:            return "EnsureLocalCapacity";
+            case JNIFunction::NewWeakGlobalRef:               return "NewWeakGlobalRef";
+            case JNIFunction::DeleteWeakGlobalRef:            return "DeleteWeakGlobalRef";
+            case JNIFunction::IsSameObject:                   return "IsSameObject";
+            case JNIFunction::AllocObject:                    return "AllocObject";
+            case JNIFunction::NewObject:                      return "NewObject";
+            case JNIFunction::GetObjectClass:                 return "GetObjectClass";
+            case JNIFunction::IsInstanceOf:                   return "IsInstanceOf";
+            case JNIFunction::GetMethodID:                    return "GetMethodID";
+            case JNIFunction::CallMethod:                     return "Call<Type>Method";
+            case JNIFunction::CallNonvirtualMethod:           return "CallNonvirtual<Type>Method";
+            case JNIFunction::GetFieldID:                     return "GetFieldID";
+            case JNIFunction::GetField:                       return "Get<Type>Field";
+            case JNIFunction::SetField:                       return "Set<Type>Field";
+            case JNIFunction::GetStaticMethodID:              return "GetStaticMethodID";
+            case JNIFunction::CallStaticMethod:               return "CallStatic<Type>Method";
+            case JNIFunction::GetStaticFieldID:               return "GetStaticFieldID";
+            case JNIFunction::GetStaticField:                 return "GetStatic<Type>Field";
+            case JNIFunction::SetStaticField:                 return "SetStatic<Type>Field";
+            case JNIFunction::NewString:                      return "NewString";
+            case JNIFunction::GetStringLength:                return "GetStringLength";
+            case JNIFunction::GetStringChars:                 return "GetStringChars";
+            case JNIFunction::ReleaseStringChars:             return "ReleaseStringChars";
+            case JNIFunction::NewStringUTF:                   return "NewStringUTF";
+            case JNIFunction::GetStringUTFLength:             return "GetStringUTFLength";
+            case JNIFunction::GetStringUTFChars:              return "GetStringUTFChars";
+            case JNIFunction::ReleaseStringUTFChars:          return "ReleaseStringUTFChars";
+            case JNIFunction::GetStringRegion:                return "GetStringRegion";
+            case JNIFunction::GetStringUTFRegion:             return "GetStringUTFRegion";
+            case JNIFunction::GetStringCritical:              return "GetStringCritical";
+            case JNIFunction::ReleaseStringCritical:          return "ReleaseStringCritical";
+            case JNIFunction::GetArrayLength:                 return "GetArrayLength";
+            case JNIFunction::NewArray:                       return "New<Type>Array";
+            case JNIFunction::GetArrayElements:               return "Get<Type>ArrayElements";
+            case JNIFunction::ReleaseArrayElements:           return "Release<Type>ArrayElements";
+            case JNIFunction::GetPrimitiveArrayCritical:      return "GetPrimitiveArrayCritical";
+            case JNIFunction::ReleasePrimitiveArrayCritical:  return "ReleasePrimitiveArrayCritical";
+            case JNIFunction::GetArrayRegion:                 return "Get<Type>ArrayRegion";
+            case JNIFunction::SetArrayRegion:                 return "Set<Type>ArrayRegion";
+            case JNIFunction::NewObjectArray:                 return "NewObjectArray";
+            case JNIFunction::GetObjectArrayElement:          return "GetObjectArrayElement";
+            case JNIFunction::SetObjectArrayElement:          return "SetObjectArrayElement";
+            case JNIFunction::RegisterNatives:                return "RegisterNatives";
+            case JNIFunction::UnregisterNatives:              return "UnregisterNatives";
+            case JNIFunction::MonitorEnter:                   return "MonitorEnter";
+            case JNIFunction::MonitorExit:                    return "MonitorExit";
+            case JNIFunction::GetJavaVM:                      return "GetJavaVM";
+            case JNIFunction::NewDirectByteBuffer:            return "NewDirectByteBuffer";
+            case JNIFunction::GetDirectBufferAddress:         return "GetDirectBufferAddress";
+            case JNIFunction::GetDirectBufferCapacity:        return "GetDirectBufferCapacity";
+            case JNIFunction::GetObjectRefType:               return "GetObjectRefType";
+           }
+        return "Unknown";
+       }
+
+
+    // Each wrapper in functions.hpp, and each deleter or helper elsewhere that calls JNI directly,
+    // constructs an `Instrumentation::Call` for the duration of the JNI call. The exception check
+    // that follows each call is not counted separately; instead, CheckJavaException calls
+    // `Instrumentation::JavaException` when it finds a pending exception. By default,
+    // Instrumentation is NullInstrumentation, which does nothing, and compiles away entirely. To
+    // use another policy, specialize InstrumentationPolicy after including this header, and before
+    // including any other jni.hpp header:
+    //
+    //   #include <jni/instrumentation.hpp>
+    //
+    //   namespace jni
+    //      {
+    //       template <> struct InstrumentationPolicy<> { using Type = CallStatistics; };
+    //      }
+    //
+    //   #include <jni/jni.hpp>
+    //
+    // As with other specializations, the choice must be the same in every translation unit.
+
+    struct NullInstrumentation
+       {
+        struct Call
+           {
+            Call(JNIEnv&, JNIFunction) {}
+           };
+
+        static void JavaException(JNIEnv&) {}
+       };
+
+    template < class = void >
+    struct InstrumentationPolicy
+       {
+        using Type = NullInstrumentation;
+       };
+
+
+    struct FunctionStatistics
+       {
+        // Bucket i counts calls taking at least 2^i and less than 2^(i+1) nanoseconds; the last
+        // bucket also counts all longer calls.
+        static constexpr std::size_t histogramBuckets = 32;
+
+        JNIFunction function;
+        std::uint64_t calls = 0;
+        std::uint64_t javaExceptions = 0;
+        std::uint64_t nanoseconds = 0;
+        std::array<std::uint64_t, histogramBuckets> histogram {};
+       };
+
+    // An instrumentation policy that records, for each JNI function, the number of calls, the
+    // number that left a pending Java exception, the total time spent, and a histogram of call
+    // latencies. Each thread records into its own counters, without locking or atomic
+    // read-modify-write operations; Snapshot sums the counters of all threads, including those
+    // that have exited. Counters are never reset; to measure an interval, take the difference of
+    // two snapshots.
+    class CallStatistics
+       {
+        private:
+            struct Counters
+               {
+                std::atomic<std::uint64_t> calls { 0 };
+                std::atomic<std::uint64_t> javaExceptions { 0 };
+                std::atomic<std::uint64_t> nanoseconds { 0 };
+                std::array<std::atomic<std::uint64_t>, FunctionStatistics::histogramBuckets> histogram {};
+               };
+
+            using ThreadCounters = std::array<Counters, jniFunctionCount>;
+            using Totals = std::array<FunctionStatistics, jniFunctionCount>;
+
+            struct Registry
+               {
+                std::mutex mutex;
+                std::vector<const ThreadCounters*> threads;
+                Totals exited {};
+               };
+
+            // Leaked, as threads may exit after static destruction.
+            static Registry& GetRegistry()
+               {
+                static Registry* registry = new Registry();
+                return *registry;
+               }
+
+            static void Accumulate(Totals& totals, const ThreadCounters& counters)
+               {
+                for (std::size_t i = 0; i < jniFunctionCount; ++i)
+                   {
+                    totals[i].calls += counters[i].calls.load(std::memory_order_relaxed);
+                    totals[i].javaExceptions += counters[i].javaExceptions.load(std::memory_order_relaxed);
+                    totals[i].nanoseconds += counters[i].nanoseconds.load(std::memory_order_relaxed);
+                    for (std::size_t b = 0; b < FunctionStatistics::histogramBuckets; ++b)
+                        totals[i].histogram[b] += counters[i].histogram[b].load(std::memory_order_relaxed);
+                   }
+               }
+
+            class ThreadRegistration
+               {
+                public:
+                    ThreadCounters counters;
+
+                    ThreadRegistration()
+                       {
+                        Registry& registry = GetRegistry();
+                        std::lock_guard<std::mutex> lock(registry.mutex);
+                        registry.threads.push_back(&counters);
+                       }
+
+                    ~ThreadRegistration()
+                       {
+                        Registry& registry = GetRegistry();
+                        std::lock_guard<std::mutex> lock(registry.mutex);
+                        Accumulate(registry.exited, counters);
+                        registry.threads.erase(std::find(registry.threads.begin(), registry.threads.end(), &counters));
+                       }
+               };
+
+            static Counters& Local(JNIFunction function)
+               {
+                static thread_local ThreadRegistration registration;
+                return registration.counters[static_cast<std::size_t>(function)];
+               }
+
+            static JNIFunction& Current()
+               {
+                static thread_local JNIFunction current = JNIFunction::GetVersion;
+                return current;
+               }
+
+            // Only the owning thread writes its counters, so a plain load and store suffices.
+            static void Add(std::atomic<std::uint64_t>& counter, std::uint64_t n = 1)
+               {
+                counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+               }
+
+            static std::size_t Bucket(std::uint64_t nanoseconds)
+               {
+                std::size_t bucket = 0;
+                while (nanoseconds >>= 1)
+                    ++bucket;
+                return bucket < FunctionStatistics::histogramBuckets ? bucket : FunctionStatistics::histogramBuckets - 1;
+               }
+
+        public:
+            class Call
+               {
+                private:
+                    JNIFunction function;
+                    std::chrono::steady_clock::time_point start;
+
+                public:
+                    Call(JNIEnv&, JNIFunction f)
+                       : function(f),
+                         start(std::chrono::steady_clock::now())
+                       {
+                        Current() = f;
+                       }
+
+                    ~Call()
+                       {
+                        const auto elapsed = std::chrono::steady_clock::now() - start;
+                        const auto nanoseconds = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+
+                        Counters& counters = Local(function);
+                        Add(counters.calls);
+                        Add(counters.nanoseconds, nanoseconds);
+                        Add(counters.histogram[Bucket(nanoseconds)]);
+                       }
+               };
+
+            // Attributed to the most recent JNI function called on this thread.
+            static void JavaException(JNIEnv&)
+               {
+                Add(Local(Current()).javaExceptions);
+               }
+
+            // Returns statistics for each function that has been called at least once.
+            static std::vector<FunctionStatistics> Snapshot()
+               {
+                Registry& registry = GetRegistry();
+                Totals totals;
+
+                   {
+                    std::lock_guard<std::mutex> lock(registry.mutex);
+                    totals = registry.exited;
+                    for (const ThreadCounters* counters : registry.threads)
+                        Accumulate(totals, *counters);
+                   }
+
+                std::vector<FunctionStatistics> result;
+                for (std::size_t i = 0; i < jniFunctionCount; ++i)
+                   {
+                    if (totals[i].calls == 0)
+                        continue;
+                    totals[i].function = static_cast<JNIFunction>(i);
+                    result.push_back(totals[i]);
+                   }
+                return result;
+               }
+       };
+
+    // Writes a snapshot as a JSON array with one object per function.
+    inline void WriteJSON(std::ostream& out, const std::vector<FunctionStatistics>& statistics)
+       {
+        out << "[";
+        for (std::size_t i = 0; i < statistics.size(); ++i)
+           {
+            const FunctionStatistics& s = statistics[i];
+            out << (i ? ",\n " : "\n ")
+                << "{\"function\":\"" << Name(s.function) << "\""
+                << ",\"calls\":" << s.calls
+                << ",\"javaExceptions\":" << s.javaExceptions
+                << ",\"nanoseconds\":" << s.nanoseconds
+                << ",\"histogram\":[";
+            for (std::size_t b = 0; b < s.histogram.size(); ++b)
+                out << (b ? "," : "") << s.histogram[b];
+            out << "]}";
+           }
+        out << "\n]\n";
+       }
+   }
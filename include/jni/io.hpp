@@ -0,0 +1,195 @@
+#pragma once
+
+// POSIX file descriptor I/O for Java byte arrays. Not included by <jni/jni.hpp>.
+
+#include <jni/functions.hpp>
+#include <jni/array.hpp>
+#include <jni/npe.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <initializer_list>
+#include <system_error>
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <limits.h>
+#include <unistd.h>
+
+namespace jni
+   {
+    // Arrays of at most this many bytes are written while pinned with GetPrimitiveArrayCritical,
+    // with no intermediate copy; larger ones are copied through a buffer of this size. Pinning blocks
+    // garbage collection for the duration of the write, so the bound should be kept small, and
+    // writes to descriptors that may block indefinitely should pass a threshold of zero.
+    constexpr std::size_t defaultCriticalWriteThreshold = 64 * 1024;
+
+    // The size of the intermediate buffer through which ReadIntoArray copies data into the array.
+    constexpr std::size_t defaultReadBufferSize = 64 * 1024;
+
+    inline void WriteFully(int fd, const jbyte* data, std::size_t length)
+       {
+        while (length > 0)
+           {
+            ssize_t written = ::write(fd, data, length);
+            if (written < 0)
+               {
+                if (errno == EINTR)
+                    continue;
+                throw std::system_error(errno, std::system_category(), "write");
+               }
+            data += written;
+            length -= static_cast<std::size_t>(written);
+           }
+       }
+
+    inline std::size_t ReadFully(int fd, jbyte* data, std::size_t length)
+       {
+        std::size_t total = 0;
+        while (total < length)
+           {
+            ssize_t read = ::read(fd, data + total, length - total);
+            if (read < 0)
+               {
+                if (errno == EINTR)
+                    continue;
+                throw std::system_error(errno, std::system_category(), "read");
+               }
+            if (read == 0)
+                break;
+            total += static_cast<std::size_t>(read);
+           }
+        return total;
+       }
+
+    inline void CheckArrayRange(JNIEnv& env, jarray<jbyte>& array, jsize offset, jsize length)
+       {
+        const jsize arrayLength = GetArrayLength(env, array);
+        if (offset > arrayLength || length > arrayLength - offset)
+            ThrowNew(env, FindClass(env, "java/lang/ArrayIndexOutOfBoundsException"));
+       }
+
+
+    // Writes `length` bytes of `array`, starting at `offset`, to `fd`, retrying on EINTR and partial
+    // writes. Errors are thrown as std::system_error.
+    inline void WriteArray(JNIEnv& env, int fd, const Array<jbyte>& array, jsize offset, jsize length,
+                           std::size_t criticalThreshold = defaultCriticalWriteThreshold)
+       {
+        auto& untagged = SafeDereference(env, array.get());
+        CheckArrayRange(env, untagged, offset, length);
+
+        if (length <= criticalThreshold)
+           {
+            auto critical = GetPrimitiveArrayCritical(env, untagged);
+            WriteFully(fd, static_cast<const jbyte*>(std::get<0>(critical).get()) + offset, length);
+            return;
+           }
+
+        std::vector<jbyte> buffer(std::max<std::size_t>(criticalThreshold, 4096));
+        for (jsize start = offset; start < offset + length; )
+           {
+            const jsize count = std::min<jsize>(buffer.size(), offset + length - start);
+            GetArrayRegion(env, untagged, start, count, buffer.data());
+            WriteFully(fd, buffer.data(), count);
+            start += count;
+           }
+       }
+
+    inline void WriteArray(JNIEnv& env, int fd, const Array<jbyte>& array)
+       {
+        WriteArray(env, fd, array, 0, array.Length(env));
+       }
+
+    // Reads up to `length` bytes from `fd` into `array`, starting at `offset`, stopping early only
+    // at end of file. Returns the number of bytes read. Data is always copied into the array with
+    // SetArrayRegion, as a read may block for an unbounded time.
+    inline jsize ReadIntoArray(JNIEnv& env, int fd, const Array<jbyte>& array, jsize offset, jsize length,
+                               std::size_t bufferSize = defaultReadBufferSize)
+       {
+        auto& untagged = SafeDereference(env, array.get());
+        CheckArrayRange(env, untagged, offset, length);
+
+        std::vector<jbyte> buffer(std::min<std::size_t>(std::max<std::size_t>(bufferSize, 1), length));
+        jsize start = offset;
+        while (start < offset + length)
+           {
+            const std::size_t wanted = std::min<std::size_t>(buffer.size(), offset + length - start);
+            const std::size_t count = ReadFully(fd, buffer.data(), wanted);
+            SetArrayRegion(env, untagged, start, count, buffer.data());
+            start += count;
+            if (count < wanted)
+                break;
+           }
+        return start - offset;
+       }
+
+
+    struct ArraySlice
+       {
+        const Array<jbyte>& array;
+        jsize offset;
+        jsize length;
+       };
+
+    // Writes several array slices to `fd` with a single writev, if their total length is within
+    // the critical threshold, by pinning all of them at once. Otherwise, writes each slice in turn
+    // with WriteArray.
+    inline void WriteArrays(JNIEnv& env, int fd, std::initializer_list<ArraySlice> slices,
+                            std::size_t criticalThreshold = defaultCriticalWriteThreshold)
+       {
+        std::size_t total = 0;
+        for (const ArraySlice& slice : slices)
+           {
+            CheckArrayRange(env, SafeDereference(env, slice.array.get()), slice.offset, slice.length);
+            total += slice.length;
+           }
+
+        if (total > criticalThreshold || slices.size() > IOV_MAX)
+           {
+            for (const ArraySlice& slice : slices)
+                WriteArray(env, fd, slice.array, slice.offset, slice.length, criticalThreshold);
+            return;
+           }
+
+        std::vector<UniquePrimitiveArrayCritical<jbyte>> pinned;
+        std::vector<iovec> iov;
+        pinned.reserve(slices.size());
+        iov.reserve(slices.size());
+
+        for (const ArraySlice& slice : slices)
+           {
+            pinned.push_back(std::move(std::get<0>(GetPrimitiveArrayCritical(env, *slice.array))));
+            iov.push_back({ static_cast<jbyte*>(pinned.back().get()) + slice.offset, slice.length });
+           }
+
+        std::size_t index = 0;
+        while (index < iov.size())
+           {
+            ssize_t written = ::writev(fd, &iov[index], static_cast<int>(iov.size() - index));
+            if (written < 0)
+               {
+                if (errno == EINTR)
+                    continue;
+                throw std::system_error(errno, std::system_category(), "writev");
+               }
+
+            std::size_t remaining = static_cast<std::size_t>(written);
+            while (index < iov.size() && remaining >= iov[index].iov_len)
+               {
+                remaining -= iov[index].iov_len;
+                ++index;
+               }
+
+            if (index < iov.size())
+               {
+                iov[index].iov_base = static_cast<char*>(iov[index].iov_base) + remaining;
+                iov[index].iov_len -= remaining;
+               }
+           }
+
+        // Release in reverse order of acquisition.
+        while (!pinned.empty())
+            pinned.pop_back();
+       }
+   }
@@ -20,7 +20,12 @@
 #include <jni/static_method.hpp>
 #include <jni/field.hpp>
 #include <jni/static_field.hpp>
+#include <jni/peer_storage.hpp>
 #include <jni/native_method.hpp>
 #include <jni/boxing.hpp>
+#include <jni/collections.hpp>
+#include <jni/struct_mapping.hpp>
+#include <jni/columnar.hpp>
+#include <jni/critical_section.hpp>
 #include <jni/advanced_ownership.hpp>
 #include <jni/weak_reference.hpp>
@@ -6,12 +6,55 @@
 #include <jni/tagging.hpp>
 #include <jni/class.hpp>
 #include <jni/object.hpp>
+#include <jni/field.hpp>
+#include <jni/array.hpp>
+#include <jni/peer_storage.hpp>
+#include <jni/tracing.hpp>
 
 #include <exception>
 #include <type_traits>
 
 namespace jni
    {
+    using Tracing = TracingPolicy<>::Type;
+
+    // Reports the local frame the JVM provides for a call of a native method to the
+    // ReferenceTracking policy. Local references still live when the method returns are released
+    // by the JVM, so the frame is released rather than popped. Does not throw: if the frame cannot
+    // be recorded, references created in it are attributed to the enclosing frame.
+    class NativeMethodFrame
+       {
+        private:
+            bool pushed = false;
+
+        public:
+            NativeMethodFrame() noexcept
+               {
+                try
+                   {
+                    ReferenceTracking::FramePushed();
+                    pushed = true;
+                   }
+                catch (...)
+                   {
+                   }
+               }
+
+            NativeMethodFrame(const NativeMethodFrame&) = delete;
+            NativeMethodFrame& operator=(const NativeMethodFrame&) = delete;
+
+            ~NativeMethodFrame()
+               {
+                if (pushed)
+                    ReferenceTracking::FrameReleased();
+               }
+       };
+
+    // Whether noexcept native methods need a wrapper, rather than being registered directly.
+    constexpr bool wrapNoexceptNativeMethods = !std::is_same<Tracing, NullTracing>::value
+                                            || !std::is_same<ReferenceTracking, NullReferenceTracking>::value;
+
+
     template < class M, class Enable = void >
     struct NativeMethodTraits;
 
@@ -38,22 +81,61 @@ namespace jni
     struct NativeMethodTraits< M, std::enable_if_t< std::is_class<M>::value > >
         : NativeMethodTraits< decltype(&M::operator()) > {};
 
+#if defined(__cpp_noexcept_function_type)
+    template < class R, class... Args >
+    struct NativeMethodTraits< R (Args...) noexcept >
+        : NativeMethodTraits< R (Args...) > {};
+
+    template < class R, class... Args >
+    struct NativeMethodTraits< R (*)(Args...) noexcept >
+        : NativeMethodTraits< R (Args...) > {};
+
+    template < class T, class R, class... Args >
+    struct NativeMethodTraits< R (T::*)(Args...) const noexcept >
+        : NativeMethodTraits< R (Args...) > {};
+
+    template < class T, class R, class... Args >
+    struct NativeMethodTraits< R (T::*)(Args...) noexcept >
+        : NativeMethodTraits< R (Args...) > {};
+#endif
+
+
+    // Whether calling a native method implementation can throw. For lambdas and function objects,
+    // this reflects the exception specification of operator(). Function pointers carry an exception
+    // specification in their type only as of C++17; before that, this is always false for them, and
+    // MakeNoexceptNativeMethod must be used instead to omit the wrapper.
+    //
+    // The wrappers produced by MakeNativeMethod translate C++ exceptions to Java exceptions with a
+    // try / catch block; for implementations which are noexcept, that wrapper is omitted.
+
+    template < class M, class = typename NativeMethodTraits<M>::Type >
+    struct IsNoexceptNativeMethod;
+
+    template < class M, class R, class... Args >
+    struct IsNoexceptNativeMethod< M, R (Args...) >
+        : std::integral_constant< bool, noexcept(std::declval<M&>()(std::declval<Args>()...)) > {};
+
 
     /// Low-level, lambda
 
     template < class M >
     auto MakeNativeMethod(const char* name, const char* sig, const M& m,
-                          std::enable_if_t< std::is_class<M>::value >* = nullptr)
+                          std::enable_if_t< std::is_class<M>::value && !IsNoexceptNativeMethod<M>::value >* = nullptr)
        {
         using FunctionType = typename NativeMethodTraits<M>::Type;
         using ResultType = typename NativeMethodTraits<M>::ResultType;
 
         static FunctionType* method = m;
 
+        // The wrapper can't capture, so it traces under the name of the first registration.
+        static const char* methodName = name;
+
         auto wrapper = [] (JNIEnv* env, auto... args)
            {
+            NativeMethodFrame frame;
             try
                {
+                Tracing::Scope scope(methodName);
                 return method(env, args...);
                }
             catch (...)
@@ -66,19 +148,75 @@ namespace jni
         return JNINativeMethod< FunctionType > { name, sig, wrapper };
        }
 
+    template < class M >
+    auto MakeNativeMethod(const char* name, const char* sig, const M& m,
+                          std::enable_if_t< std::is_class<M>::value && IsNoexceptNativeMethod<M>::value >* = nullptr)
+       {
+        using FunctionType = typename NativeMethodTraits<M>::Type;
+
+        if (!wrapNoexceptNativeMethods)
+           {
+            FunctionType* method = m;
+            return JNINativeMethod< FunctionType > { name, sig, method };
+           }
+
+        static FunctionType* method = m;
+        static const char* methodName = name;
+
+        // Not declared noexcept: as of C++17, a noexcept generic lambda does not convert to the
+        // FunctionType pointer. Neither the method nor the frame and tracing scope throw.
+        auto wrapper = [] (JNIEnv* env, auto... args)
+           {
+            NativeMethodFrame frame;
+            Tracing::Scope scope(methodName);
+            return method(env, args...);
+           };
+
+        return JNINativeMethod< FunctionType > { name, sig, wrapper };
+       }
+
 
     /// Low-level, function pointer
 
+    // Registers `method`, which must not throw, without an exception-translating wrapper, as
+    // MakeNativeMethod does for noexcept lambdas. Needed for function pointers before C++17, where
+    // noexcept is not part of a function's type.
     template < class M, M method >
-    auto MakeNativeMethod(const char* name, const char* sig)
+    auto MakeNoexceptNativeMethod(const char* name, const char* sig)
+       {
+        using FunctionType = typename NativeMethodTraits<M>::Type;
+
+        if (!wrapNoexceptNativeMethods)
+            return JNINativeMethod< FunctionType > { name, sig, method };
+
+        static const char* methodName = name;
+
+        // Not declared noexcept, as above.
+        auto wrapper = [] (JNIEnv* env, auto... args)
+           {
+            NativeMethodFrame frame;
+            Tracing::Scope scope(methodName);
+            return method(env, args...);
+           };
+
+        return JNINativeMethod< FunctionType > { name, sig, wrapper };
+       }
+
+    template < class M, M method >
+    auto MakeNativeMethod(const char* name, const char* sig,
+                          std::enable_if_t< !IsNoexceptNativeMethod<M>::value >* = nullptr)
        {
         using FunctionType = typename NativeMethodTraits<M>::Type;
         using ResultType = typename NativeMethodTraits<M>::ResultType;
 
+        static const char* methodName = name;
+
         auto wrapper = [] (JNIEnv* env, auto... args)
            {
+            NativeMethodFrame frame;
             try
                {
+                Tracing::Scope scope(methodName);
                 return method(env, args...);
                }
             catch (...)
@@ -91,6 +229,13 @@ namespace jni
         return JNINativeMethod< FunctionType > { name, sig, wrapper };
        }
 
+    template < class M, M method >
+    auto MakeNativeMethod(const char* name, const char* sig,
+                          std::enable_if_t< IsNoexceptNativeMethod<M>::value >* = nullptr)
+       {
+        return MakeNoexceptNativeMethod<M, method>(name, sig);
+       }
+
 
     /// High-level, lambda
 
@@ -105,7 +250,7 @@ namespace jni
            {
             static M method(m);
 
-            auto wrapper = [] (JNIEnv* env, UntaggedType<Subject> subject, UntaggedType<Args>... args)
+            auto wrapper = [] (JNIEnv* env, UntaggedType<Subject> subject, UntaggedType<Args>... args) noexcept(IsNoexceptNativeMethod<M>::value)
                {
                 return ReleaseUnique(method(*env, AsLvalue(Tag<std::decay_t<Subject>>(*env, *subject)), AsLvalue(Tag<std::decay_t<Args>>(*env, args))...));
                };
@@ -122,7 +267,7 @@ namespace jni
            {
             static M method(m);
 
-            auto wrapper = [] (JNIEnv* env, UntaggedType<Subject> subject, UntaggedType<Args>... args)
+            auto wrapper = [] (JNIEnv* env, UntaggedType<Subject> subject, UntaggedType<Args>... args) noexcept(IsNoexceptNativeMethod<M>::value)
                {
                 method(*env, AsLvalue(Tag<std::decay_t<Subject>>(*env, *subject)), AsLvalue(Tag<std::decay_t<Args>>(*env, args))...);
                };
@@ -131,6 +276,12 @@ namespace jni
            }
        };
 
+#if defined(__cpp_noexcept_function_type)
+    template < class T, class R, class Subject, class... Args >
+    struct NativeMethodMaker< R (T::*)(JNIEnv&, Subject, Args...) const noexcept >
+        : NativeMethodMaker< R (T::*)(JNIEnv&, Subject, Args...) const > {};
+#endif
+
     template < class M >
     auto MakeNativeMethod(const char* name, const M& m)
        {
@@ -143,9 +294,10 @@ namespace jni
     template < class R, class Subject, class... Args, R (*method)(JNIEnv&, Subject, Args...) >
     struct NativeMethodMaker< R (JNIEnv&, Subject, Args...), method >
        {
+        template < bool Noexcept = IsNoexceptNativeMethod<decltype(method)>::value >
         auto operator()(const char* name)
            {
-            auto wrapper = [] (JNIEnv* env, UntaggedType<Subject> subject, UntaggedType<Args>... args)
+            auto wrapper = [] (JNIEnv* env, UntaggedType<Subject> subject, UntaggedType<Args>... args) noexcept(Noexcept)
                {
                 return ReleaseUnique(method(*env, AsLvalue(Tag<std::decay_t<Subject>>(*env, *subject)), AsLvalue(Tag<std::decay_t<Args>>(*env, args))...));
                };
@@ -157,9 +309,10 @@ namespace jni
     template < class Subject, class... Args, void (*method)(JNIEnv&, Subject, Args...) >
     struct NativeMethodMaker< void (JNIEnv&, Subject, Args...), method >
        {
+        template < bool Noexcept = IsNoexceptNativeMethod<decltype(method)>::value >
         auto operator()(const char* name)
            {
-            auto wrapper = [] (JNIEnv* env, UntaggedType<Subject> subject, UntaggedType<Args>... args)
+            auto wrapper = [] (JNIEnv* env, UntaggedType<Subject> subject, UntaggedType<Args>... args) noexcept(Noexcept)
                {
                 method(*env, AsLvalue(Tag<std::decay_t<Subject>>(*env, *subject)), AsLvalue(Tag<std::decay_t<Args>>(*env, args))...);
                };
@@ -175,6 +328,123 @@ namespace jni
         return NativeMethodMaker<FunctionType, method>()(name);
        }
 
+    // As above, for a function which must not throw. See the low-level MakeNoexceptNativeMethod.
+    template < class M, M method >
+    auto MakeNoexceptNativeMethod(const char* name)
+       {
+        using FunctionType = typename NativeMethodTraits<M>::Type;
+        return NativeMethodMaker<FunctionType, method>().template operator()<true>(name);
+       }
+
+
+    /// Critical native
+    //
+    // A critical native method (Android's @CriticalNative) is called without a JNIEnv or jclass, and
+    // is restricted to primitive parameter and result types. It cannot raise Java exceptions, so no
+    // try / catch wrapper is generated: the function itself is registered, and the signature is
+    // computed automatically. Eligibility is checked at compile time.
+    //
+    // @FastNative methods keep the ordinary JNI calling convention; register them with the
+    // MakeNativeMethod overloads above. HotSpot's JavaCritical_ entry points are located by symbol
+    // name rather than through RegisterNatives, so they are not supported here.
+
+    template < class F >
+    struct IsCriticalNativeFunction : std::false_type {};
+
+    template < class R, class... Args >
+    struct IsCriticalNativeFunction< R (Args...) >
+        : std::integral_constant< bool, (IsPrimitive<R>::value || std::is_void<R>::value)
+                                     && Conjunction<IsPrimitive<Args>...>::value > {};
+
+    template < class M, M method >
+    auto MakeCriticalNativeMethod(const char* name)
+       {
+        using FunctionType = typename NativeMethodTraits<M>::Type;
+        static_assert(IsCriticalNativeFunction<FunctionType>::value,
+                      "critical native methods must have only primitive parameter and result types");
+
+        return JNINativeMethod< FunctionType > { name, TypeSignature<FunctionType>()(), method };
+       }
+
+    template < class M >
+    auto MakeCriticalNativeMethod(const char* name, const M& m,
+                                  std::enable_if_t< std::is_class<M>::value >* = nullptr)
+       {
+        using FunctionType = typename NativeMethodTraits<M>::Type;
+        static_assert(IsCriticalNativeFunction<FunctionType>::value,
+                      "critical native methods must have only primitive parameter and result types");
+
+        FunctionType* method = m;
+        return JNINativeMethod< FunctionType > { name, TypeSignature<FunctionType>()(), method };
+       }
+
+
+    /// High-level peer, lookup helpers
+
+    [[noreturn]] inline void ThrowInvalidNativePeer(JNIEnv& env)
+       {
+        ThrowNew(env, FindClass(env, "java/lang/IllegalStateException"), "invalid native peer");
+       }
+
+    // Get<Type>Field cannot raise a Java exception given a valid object and field ID, so the
+    // peer field is read directly, skipping the ExceptionCheck that Object::Get would perform.
+    template < class P, class TagType >
+    P& GetNativePeer(JNIEnv& env, const Object<TagType>& obj, const Field<TagType, jlong>& field)
+       {
+        jfieldID& id = field;
+        jlong peer;
+           {
+            Instrumentation::Call call(env, JNIFunction::GetField);
+            peer = (env.*(TypedMethods<jlong>::GetField))(Unwrap(obj.get()), Unwrap(id));
+           }
+        auto ptr = NativePeerStorage<P>::Get(peer);
+        if (!ptr) ThrowInvalidNativePeer(env);
+        return *ptr;
+       }
+
+    template < class P >
+    P& GetNativePeer(JNIEnv& env, jlong handle)
+       {
+        auto ptr = NativePeerStorage<P>::Get(handle);
+        if (!ptr) ThrowInvalidNativePeer(env);
+        return *ptr;
+       }
+
+    // Calls `f` with the peer for `handle`. For a noexcept `f`, an invalid handle leaves an
+    // IllegalStateException pending and returns a default value rather than throwing, so that the
+    // native method wrapper can be noexcept too.
+    template < class P, class F >
+    auto CallWithNativePeer(JNIEnv& env, jlong handle, F&& f, std::false_type /* noexcept */)
+       {
+        return f(GetNativePeer<P>(env, handle));
+       }
+
+    template < class P, class F >
+    auto CallWithNativePeer(JNIEnv& env, jlong handle, F&& f, std::true_type /* noexcept */) noexcept
+       {
+        using ResultType = decltype(f(std::declval<P&>()));
+
+        auto ptr = NativePeerStorage<P>::Get(handle);
+        if (!ptr)
+           {
+            ::jclass clazz;
+               {
+                Instrumentation::Call call(env, JNIFunction::FindClass);
+                clazz = env.FindClass("java/lang/IllegalStateException");
+               }
+
+            if (clazz)
+               {
+                Instrumentation::Call call(env, JNIFunction::ThrowNew);
+                env.ThrowNew(clazz, "invalid native peer");
+               }
+
+            return ResultType();
+           }
+
+        return f(*ptr);
+       }
+
 
     /// High-level peer, lambda
 
@@ -198,7 +468,7 @@ namespace jni
                {
                 auto wrapper = [field, lambda = lambda] (JNIEnv& env, Object<TagType>& obj, Args... args)
                    {
-                    return lambda(env, *reinterpret_cast<P*>(obj.Get(env, field)), args...);
+                    return lambda(env, GetNativePeer<P>(env, obj, field), args...);
                    };
 
                 return MakeNativeMethod(name, wrapper);
@@ -234,10 +504,7 @@ namespace jni
                {
                 auto wrapper = [field] (JNIEnv& env, Object<TagType>& obj, Args... args)
                    {
-                    auto ptr = reinterpret_cast<P*>(obj.Get(env, field));
-                    if (ptr) return method(env, *ptr, args...);
-                    ThrowNew(env, jni::FindClass(env, "java/lang/IllegalStateException"),
-                             "invalid native peer");
+                    return method(env, GetNativePeer<P>(env, obj, field), args...);
                    };
 
                 return MakeNativeMethod(name, wrapper);
@@ -273,10 +540,7 @@ namespace jni
                {
                 auto wrapper = [field] (JNIEnv& env, Object<TagType>& obj, Args... args)
                    {
-                    auto ptr = reinterpret_cast<P*>(obj.Get(env, field));
-                    if (ptr) return (ptr->*method)(env, args...);
-                    ThrowNew(env, jni::FindClass(env, "java/lang/IllegalStateException"),
-                             "invalid native peer");
+                    return (GetNativePeer<P>(env, obj, field).*method)(env, args...);
                    };
                 return MakeNativeMethod(name, wrapper);
                }
@@ -290,6 +554,146 @@ namespace jni
        }
 
 
+    /**
+     * Variants of the above for the "nativePtr" pattern, where the Java side keeps the peer
+     * handle and passes it to a static native method as a leading `long` parameter:
+     *
+     *     private static native boolean nativeIsReady(long nativePtr, int flags);
+     *
+     * The generated signature is that of the peer method with `J` prepended, and the wrapper
+     * converts the handle to a reference to the peer without any JNI calls. The peer field
+     * passed by `RegisterNativePeer` is ignored, so these may be mixed freely with
+     * `MakeNativePeerMethod` methods in a single registration.
+     *
+     * If the peer method is noexcept (for function and member function pointers, detectable only
+     * as of C++17), so is the wrapper, and an invalid handle raises IllegalStateException without
+     * throwing a C++ exception.
+     */
+
+    /// High-level peer handle, lambda
+
+    template < class L, class >
+    class NativePeerHandleLambdaMethod;
+
+    template < class L, class R, class P, class... Args >
+    class NativePeerHandleLambdaMethod< L, R (L::*)(JNIEnv&, P&, Args...) const >
+       {
+        private:
+            const char* name;
+            L lambda;
+
+        public:
+            NativePeerHandleLambdaMethod(const char* n, const L& l)
+               : name(n), lambda(l)
+               {}
+
+            template < class Peer, class TagType, class = std::enable_if_t< std::is_same<P, Peer>::value > >
+            auto operator()(const Field<TagType, jlong>&)
+               {
+                using Noexcept = std::integral_constant<bool, IsNoexceptNativeMethod<L>::value>;
+
+                auto wrapper = [lambda = lambda] (JNIEnv& env, Class<TagType>&, jlong handle, Args... args) noexcept(Noexcept::value)
+                   {
+                    return CallWithNativePeer<P>(env, handle, [&] (P& peer) noexcept(Noexcept::value) { return lambda(env, peer, args...); }, Noexcept());
+                   };
+
+                return MakeNativeMethod(name, wrapper);
+               }
+       };
+
+#if defined(__cpp_noexcept_function_type)
+    template < class L, class R, class P, class... Args >
+    class NativePeerHandleLambdaMethod< L, R (L::*)(JNIEnv&, P&, Args...) const noexcept >
+        : public NativePeerHandleLambdaMethod< L, R (L::*)(JNIEnv&, P&, Args...) const >
+       {
+        public:
+            using NativePeerHandleLambdaMethod< L, R (L::*)(JNIEnv&, P&, Args...) const >::NativePeerHandleLambdaMethod;
+       };
+#endif
+
+    template < class L >
+    auto MakeNativePeerHandleMethod(const char* name, const L& lambda,
+                                    std::enable_if_t< std::is_class<L>::value >* = nullptr)
+       {
+        return NativePeerHandleLambdaMethod<L, decltype(&L::operator())>(name, lambda);
+       }
+
+    /// High-level peer handle, function pointer
+
+    template < class M, M* >
+    class NativePeerHandleFunctionPointerMethod;
+
+    template < class R, class P, class... Args, R (*method)(JNIEnv&, P&, Args...) >
+    class NativePeerHandleFunctionPointerMethod< R (JNIEnv&, P&, Args...), method >
+       {
+        private:
+            const char* name;
+
+        public:
+            NativePeerHandleFunctionPointerMethod(const char* n)
+               : name(n)
+               {}
+
+            template < class Peer, class TagType, class = std::enable_if_t< std::is_same<P, Peer>::value > >
+            auto operator()(const Field<TagType, jlong>&)
+               {
+                using Noexcept = std::integral_constant<bool, IsNoexceptNativeMethod<decltype(method)>::value>;
+
+                auto wrapper = [] (JNIEnv& env, Class<TagType>&, jlong handle, Args... args) noexcept(Noexcept::value)
+                   {
+                    return CallWithNativePeer<P>(env, handle, [&] (P& peer) noexcept(Noexcept::value) { return method(env, peer, args...); }, Noexcept());
+                   };
+
+                return MakeNativeMethod(name, wrapper);
+               }
+       };
+
+    template < class M, M method >
+    auto MakeNativePeerHandleMethod(const char* name,
+                                    std::enable_if_t< !std::is_member_function_pointer<M>::value >* = nullptr)
+       {
+        using FunctionType = typename NativeMethodTraits<M>::Type;
+        return NativePeerHandleFunctionPointerMethod<FunctionType, method>(name);
+       }
+
+    /// High-level peer handle, member function pointer
+
+    template < class M, M >
+    class NativePeerHandleMemberFunctionMethod;
+
+    template < class R, class P, class... Args, R (P::*method)(JNIEnv&, Args...) >
+    class NativePeerHandleMemberFunctionMethod< R (P::*)(JNIEnv&, Args...), method >
+       {
+        private:
+            const char* name;
+
+        public:
+            NativePeerHandleMemberFunctionMethod(const char* n)
+               : name(n)
+               {}
+
+            template < class Peer, class TagType, class = std::enable_if_t< std::is_same<P, Peer>::value > >
+            auto operator()(const Field<TagType, jlong>&)
+               {
+                using Noexcept = std::integral_constant<bool, noexcept((std::declval<P&>().*method)(std::declval<JNIEnv&>(), std::declval<Args>()...))>;
+
+                auto wrapper = [] (JNIEnv& env, Class<TagType>&, jlong handle, Args... args) noexcept(Noexcept::value)
+                   {
+                    return CallWithNativePeer<P>(env, handle, [&] (P& peer) noexcept(Noexcept::value) { return (peer.*method)(env, args...); }, Noexcept());
+                   };
+
+                return MakeNativeMethod(name, wrapper);
+               }
+       };
+
+    template < class M, M method >
+    auto MakeNativePeerHandleMethod(const char* name,
+                                    std::enable_if_t< std::is_member_function_pointer<M>::value >* = nullptr)
+       {
+        return NativePeerHandleMemberFunctionMethod<M, method>(name);
+       }
+
+
     /**
      * A registration function for native methods on a "native peer": a long-lived native
      * object corresponding to a Java object, usually created when the Java object is created
@@ -306,7 +710,8 @@ namespace jni
      *
      * An overload is provided that accepts a Callable object with a unique_ptr result type and
      * the names for native creation and finalization methods, allowing creation and disposal of
-     * the native peer from Java.
+     * the native peer from Java. A further overload accepts `NativePeerDisposers` in place of the
+     * finalization method name, for disposal via `java.lang.ref.Cleaner`.
      *
      * For an example of all of the above, see the `examples` directory.
      */
@@ -321,19 +726,23 @@ namespace jni
     template < class Peer, class TagType, class >
     struct NativePeerHelper;
 
-    template < class Peer, class TagType, class... Args >
-    struct NativePeerHelper< Peer, TagType, std::unique_ptr<Peer> (JNIEnv&, Args...) >
+    template < class Peer, class TagType, class Deleter, class... Args >
+    struct NativePeerHelper< Peer, TagType, std::unique_ptr<Peer, Deleter> (JNIEnv&, Args...) >
        {
-        using UniquePeer = std::unique_ptr<Peer>;
+        using Storage = NativePeerStorage<Peer>;
+        using UniquePeer = std::unique_ptr<Peer, Deleter>;
         using Initializer = UniquePeer (JNIEnv&, Args...);
 
+        static_assert(std::is_same<UniquePeer, typename Storage::UniquePeer>::value,
+                      "the initializer must return NativePeerStorage<Peer>::UniquePeer; use MakePeer");
+
         auto MakeInitializer(const Field<TagType, jlong>& field, const char* name, Initializer* initializer) const
            {
             auto wrapper = [field, initializer] (JNIEnv& e, Object<TagType>& obj, std::decay_t<Args>&... args)
                {
-                UniquePeer previous(reinterpret_cast<Peer*>(obj.Get(e, field)));
+                UniquePeer previous(Storage::Reclaim(obj.Get(e, field)));
                 UniquePeer instance(initializer(e, args...));
-                obj.Set(e, field, reinterpret_cast<jlong>(instance.get()));
+                obj.Set(e, field, Storage::Handle(instance));
                 instance.release();
                };
 
@@ -344,13 +753,34 @@ namespace jni
            {
             auto wrapper = [field] (JNIEnv& e, Object<TagType>& obj)
                {
-                UniquePeer instance(reinterpret_cast<Peer*>(obj.Get(e, field)));
+                UniquePeer instance(Storage::Reclaim(obj.Get(e, field)));
                 if (instance) obj.Set(e, field, jlong(0));
                 instance.reset();
                };
 
             return MakeNativeMethod(name, wrapper);
            }
+
+        auto MakeDisposer(const char* name) const
+           {
+            auto wrapper = [] (JNIEnv&, Class<TagType>&, jlong handle)
+               {
+                Storage::Reclaim(handle).reset();
+               };
+
+            return MakeNativeMethod(name, wrapper);
+           }
+
+        auto MakeBatchDisposer(const char* name) const
+           {
+            auto wrapper = [] (JNIEnv& e, Class<TagType>&, Array<jlong>& handles)
+               {
+                for (jlong handle : Make<std::vector<jlong>>(e, handles))
+                    Storage::Reclaim(handle).reset();
+               };
+
+            return MakeNativeMethod(name, wrapper);
+           }
        };
 
     template < class Peer, class TagType, class Initializer, class... Methods >
@@ -371,11 +801,49 @@ namespace jni
             methods.template operator()<Peer>(field)...);
        }
 
+    /**
+     * Names of the static native methods through which a peer may be disposed from a
+     * `java.lang.ref.Cleaner` action (or a `PhantomReference` queue drainer), as an alternative to
+     * a `finalize` method:
+     *
+     *     private static native void nativeDispose(long peer);
+     *     private static native void nativeDisposeAll(long[] peers);
+     *
+     * The Cleaner action must capture only the value of the peer field, read after the initializer
+     * has run, and never the Java object itself. The batch method lets a drainer that has collected
+     * several dead handles dispose of all of them with a single JNI transition.
+     */
+    struct NativePeerDisposers
+       {
+        const char* disposeMethodName;
+        const char* disposeAllMethodName;
+       };
+
+    template < class Peer, class TagType, class Initializer, class... Methods >
+    void RegisterNativePeer(JNIEnv& env, const Class<TagType>& clazz, const char* fieldName,
+                            Initializer initialize,
+                            const char* initializeMethodName,
+                            NativePeerDisposers disposers,
+                            Methods&&... methods)
+       {
+        static Field<TagType, jlong> field { env, clazz, fieldName };
+
+        using InitializerMethodType = typename NativeMethodTraits<Initializer>::Type;
+        NativePeerHelper<Peer, TagType, InitializerMethodType> helper;
+
+        RegisterNatives(env, *clazz,
+            helper.MakeInitializer(field, initializeMethodName, initialize),
+            helper.MakeDisposer(disposers.disposeMethodName),
+            helper.MakeBatchDisposer(disposers.disposeAllMethodName),
+            methods.template operator()<Peer>(field)...);
+       }
+
      // Like std::make_unique, but with non-universal reference arguments, so it can be
-     // explicitly specialized (jni::MakePeer<Peer, jni::jboolean, ...>).
+     // explicitly specialized (jni::MakePeer<Peer, jni::jboolean, ...>). The peer is allocated
+     // by NativePeerStorage<Peer>.
      template < class Peer, class... Args >
-     std::unique_ptr<Peer> MakePeer(jni::JNIEnv& env, Args... args)
+     typename NativePeerStorage<Peer>::UniquePeer MakePeer(jni::JNIEnv& env, Args... args)
         {
-         return std::make_unique<Peer>(env, args...);
+         return NativePeerStorage<Peer>::Make(env, args...);
         }
    }
@@ -1,17 +1,26 @@
 #pragma once
 
 #include <jni/types.hpp>
+#include <jni/errors.hpp>
 #include <jni/wrapping.hpp>
 #include <jni/typed_methods.hpp>
+#include <jni/reference_tracking.hpp>
+
+#include <type_traits>
 
 namespace jni
    {
+    using ReferenceTracking = ReferenceTrackingPolicy<>::Type;
+
+
     struct LocalFrameDeleter
        {
         void operator()(JNIEnv* env) const
            {
             if (env)
                {
+                ReferenceTracking::FramePopped();
+                Instrumentation::Call call(*env, JNIFunction::PopLocalFrame);
                 env->PopLocalFrame(nullptr);
                }
            }
@@ -22,6 +31,20 @@ namespace jni
 
     using RefDeletionMethod = void (JNIEnv::*)(::jobject);
 
+    template < RefDeletionMethod >
+    struct ReferenceKindOf;
+
+    template <> struct ReferenceKindOf< &JNIEnv::DeleteLocalRef >      : std::integral_constant< ReferenceKind, ReferenceKind::Local > {};
+    template <> struct ReferenceKindOf< &JNIEnv::DeleteGlobalRef >     : std::integral_constant< ReferenceKind, ReferenceKind::Global > {};
+    template <> struct ReferenceKindOf< &JNIEnv::DeleteWeakGlobalRef > : std::integral_constant< ReferenceKind, ReferenceKind::WeakGlobal > {};
+
+    template < RefDeletionMethod >
+    struct JNIFunctionOf;
+
+    template <> struct JNIFunctionOf< &JNIEnv::DeleteLocalRef >      : std::integral_constant< JNIFunction, JNIFunction::DeleteLocalRef > {};
+    template <> struct JNIFunctionOf< &JNIEnv::DeleteGlobalRef >     : std::integral_constant< JNIFunction, JNIFunction::DeleteGlobalRef > {};
+    template <> struct JNIFunctionOf< &JNIEnv::DeleteWeakGlobalRef > : std::integral_constant< JNIFunction, JNIFunction::DeleteWeakGlobalRef > {};
+
     template < RefDeletionMethod DeleteRef >
     class DefaultRefDeleter
        {
@@ -37,6 +60,8 @@ namespace jni
                 if (p)
                    {
                     assert(env);
+                    ReferenceTracking::Deleted(ReferenceKindOf<DeleteRef>::value, p);
+                    Instrumentation::Call call(*env, JNIFunctionOf<DeleteRef>::value);
                     (env->*DeleteRef)(Unwrap(p));
                    }
                }
@@ -71,6 +96,7 @@ namespace jni
                    {
                     assert(env);
                     assert(string);
+                    Instrumentation::Call call(*env, JNIFunction::ReleaseStringChars);
                     env->ReleaseStringChars(Unwrap(string), Unwrap(p));
                    }
                }
@@ -95,6 +121,7 @@ namespace jni
                    {
                     assert(env);
                     assert(string);
+                    Instrumentation::Call call(*env, JNIFunction::ReleaseStringUTFChars);
                     env->ReleaseStringUTFChars(Unwrap(string), p);
                    }
                }
@@ -119,6 +146,7 @@ namespace jni
                    {
                     assert(env);
                     assert(string);
+                    Instrumentation::Call call(*env, JNIFunction::ReleaseStringCritical);
                     env->ReleaseStringCritical(Unwrap(string), Unwrap(p));
                    }
                }
@@ -144,6 +172,7 @@ namespace jni
                    {
                     assert(env);
                     assert(array);
+                    Instrumentation::Call call(*env, JNIFunction::ReleaseArrayElements);
                     (env->*(TypedMethods<E>::ReleaseArrayElements))(Unwrap(array), p, JNI_ABORT);
                    }
                }
@@ -170,6 +199,7 @@ namespace jni
                    {
                     assert(env);
                     assert(array);
+                    Instrumentation::Call call(*env, JNIFunction::ReleasePrimitiveArrayCritical);
                     env->ReleasePrimitiveArrayCritical(Unwrap(array), p, JNI_ABORT);
                    }
                }
@@ -193,6 +223,7 @@ namespace jni
                 if (p)
                    {
                     assert(env);
+                    Instrumentation::Call call(*env, JNIFunction::MonitorExit);
                     env->MonitorExit(Unwrap(p));
                    }
                }
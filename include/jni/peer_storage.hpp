@@ -0,0 +1,219 @@
+#pragma once
+
+#include <jni/types.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace jni
+   {
+    // Controls how a native peer is allocated, and how it is encoded in the Java `long` field
+    // (or `long` parameter) that refers to it. The default stores a heap-allocated peer as a
+    // raw pointer.
+    //
+    // Specializations must provide:
+    //
+    //   using UniquePeer = ...;                         // owning pointer type
+    //   static UniquePeer Make(JNIEnv&, Args...);       // allocate and construct a peer
+    //   static jlong Handle(const UniquePeer&);         // encode a peer as a handle
+    //   static Peer* Get(jlong);                        // decode a handle; nullptr if invalid
+    //   static UniquePeer Reclaim(jlong);               // decode a handle, taking ownership
+    //
+    // To allocate a peer type from a slab pool with stale handle detection, use:
+    //
+    //   template <> struct jni::NativePeerStorage<MyPeer> : jni::PooledPeerStorage<MyPeer> {};
+    //
+    template < class Peer >
+    struct NativePeerStorage
+       {
+        using UniquePeer = std::unique_ptr<Peer>;
+
+        template < class... Args >
+        static UniquePeer Make(JNIEnv& env, Args&&... args)
+           {
+            return std::make_unique<Peer>(env, std::forward<Args>(args)...);
+           }
+
+        static jlong Handle(const UniquePeer& peer)
+           {
+            return reinterpret_cast<jlong>(peer.get());
+           }
+
+        static Peer* Get(jlong handle)
+           {
+            return reinterpret_cast<Peer*>(handle);
+           }
+
+        static UniquePeer Reclaim(jlong handle)
+           {
+            return UniquePeer(Get(handle));
+           }
+       };
+
+
+    // Per-type slab pool for native peers. Slots are allocated in fixed-size slabs that are never
+    // returned to the system, and reused through a free list.
+    //
+    // A handle encodes the slot index plus one in its low 32 bits, and the slot's generation in its
+    // high 32 bits. The generation is incremented when a peer is destroyed, so any handle to it that
+    // remains in Java -- for instance, one that is used after finalization -- no longer decodes to a
+    // peer, and the native method wrappers throw IllegalStateException rather than crashing.
+    //
+    // Lookup is lock-free; allocation and deallocation take a per-type mutex.
+    template < class Peer, std::size_t SlabSize = 256, std::size_t MaxSlabs = 65536 >
+    class PooledPeerStorage
+       {
+        private:
+            struct Slot
+               {
+                typename std::aligned_storage<sizeof(Peer), alignof(Peer)>::type storage;
+                std::atomic<std::uint32_t> generation { 0 };
+                std::atomic<bool> live { false };
+                std::uint32_t index = 0;
+               };
+
+            struct Slab
+               {
+                std::array<Slot, SlabSize> slots;
+               };
+
+            class Pool
+               {
+                private:
+                    std::array<std::atomic<Slab*>, MaxSlabs> slabs {};
+                    std::mutex mutex;
+                    std::vector<std::uint32_t> free;
+                    std::uint32_t next = 0;
+
+                public:
+                    Slot* Allocate()
+                       {
+                        std::lock_guard<std::mutex> lock(mutex);
+
+                        if (!free.empty())
+                           {
+                            std::uint32_t index = free.back();
+                            free.pop_back();
+                            return &At(index);
+                           }
+
+                        if (next == SlabSize * MaxSlabs)
+                            throw std::bad_alloc();
+
+                        if (next % SlabSize == 0)
+                           {
+                            Slab* slab = new Slab;
+                            for (std::size_t i = 0; i < SlabSize; ++i)
+                                slab->slots[i].index = static_cast<std::uint32_t>(next + i);
+                            slabs[next / SlabSize].store(slab, std::memory_order_release);
+                           }
+
+                        return &At(next++);
+                       }
+
+                    void Deallocate(Slot& slot)
+                       {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        free.push_back(slot.index);
+                       }
+
+                    Slot* Find(std::uint32_t index) const
+                       {
+                        if (index >= SlabSize * MaxSlabs)
+                            return nullptr;
+                        Slab* slab = slabs[index / SlabSize].load(std::memory_order_acquire);
+                        return slab ? &slab->slots[index % SlabSize] : nullptr;
+                       }
+
+                private:
+                    Slot& At(std::uint32_t index) const
+                       {
+                        return slabs[index / SlabSize].load(std::memory_order_relaxed)->slots[index % SlabSize];
+                       }
+               };
+
+            static Pool& GetPool()
+               {
+                // Intentionally leaked: handles may be looked up during static destruction.
+                static Pool* pool = new Pool;
+                return *pool;
+               }
+
+            static Slot& SlotOf(Peer* peer)
+               {
+                static_assert(std::is_standard_layout<Slot>::value, "");
+                return *reinterpret_cast<Slot*>(peer);
+               }
+
+        public:
+            struct Deleter
+               {
+                void operator()(Peer* peer) const
+                   {
+                    Slot& slot = SlotOf(peer);
+                    peer->~Peer();
+                    slot.live.store(false, std::memory_order_relaxed);
+                    slot.generation.fetch_add(1, std::memory_order_release);
+                    GetPool().Deallocate(slot);
+                   }
+               };
+
+            using UniquePeer = std::unique_ptr<Peer, Deleter>;
+
+            template < class... Args >
+            static UniquePeer Make(JNIEnv& env, Args&&... args)
+               {
+                Pool& pool = GetPool();
+                Slot* slot = pool.Allocate();
+
+                try
+                   {
+                    new (&slot->storage) Peer(env, std::forward<Args>(args)...);
+                   }
+                catch (...)
+                   {
+                    pool.Deallocate(*slot);
+                    throw;
+                   }
+
+                slot->live.store(true, std::memory_order_release);
+                return UniquePeer(reinterpret_cast<Peer*>(&slot->storage));
+               }
+
+            static jlong Handle(const UniquePeer& peer)
+               {
+                if (!peer)
+                    return 0;
+                const Slot& slot = SlotOf(peer.get());
+                std::uint64_t generation = slot.generation.load(std::memory_order_relaxed);
+                return static_cast<jlong>((generation << 32) | (std::uint64_t(slot.index) + 1));
+               }
+
+            static Peer* Get(jlong handle)
+               {
+                std::uint64_t bits = static_cast<std::uint64_t>(handle);
+                std::uint32_t index = static_cast<std::uint32_t>(bits);
+                if (index == 0)
+                    return nullptr;
+
+                Slot* slot = GetPool().Find(index - 1);
+                if (!slot
+                    || !slot->live.load(std::memory_order_acquire)
+                    || slot->generation.load(std::memory_order_acquire) != static_cast<std::uint32_t>(bits >> 32))
+                    return nullptr;
+
+                return reinterpret_cast<Peer*>(&slot->storage);
+               }
+
+            static UniquePeer Reclaim(jlong handle)
+               {
+                return UniquePeer(Get(handle));
+               }
+       };
+   }
@@ -0,0 +1,484 @@
+#pragma once
+
+#include <jni/types.hpp>
+#include <jni/instrumentation.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace jni
+   {
+    enum class ReferenceKind : std::size_t
+       {
+        Local,
+        Global,
+        WeakGlobal
+       };
+
+    constexpr std::size_t referenceKindCount = static_cast<std::size_t>(ReferenceKind::WeakGlobal) + 1;
+
+    inline const char* Name(ReferenceKind kind)
+       {
+        switch (kind)
+           {
+            case ReferenceKind::Local:       return "Local";
+            case ReferenceKind::Global:      return "Global";
+            case ReferenceKind::WeakGlobal:  return "WeakGlobal";
+           }
+        return "Unknown";
+       }
+
+
+    // The library reports to the `ReferenceTracking` policy each reference it creates or deletes:
+    // local references returned by JNI functions, and global and weak global references created by
+    // NewGlobalRef and NewWeakGlobalRef. It also reports each local frame pushed and popped. Two
+    // kinds of frame are released, rather than popped, as the references left in them are not
+    // leaked: the frame the JVM provides for each call of a native method registered with
+    // MakeNativeMethod, and the frames that ReleaseLocalFrame pops, such as those with which
+    // ForEachElement batches its references. By default, ReferenceTracking is
+    // NullReferenceTracking, which does nothing, and compiles away entirely. As with
+    // InstrumentationPolicy, to use another policy, specialize ReferenceTrackingPolicy after
+    // including this header, and before including any other jni.hpp header:
+    //
+    //   #include <jni/reference_tracking.hpp>
+    //
+    //   namespace jni
+    //      {
+    //       template <> struct ReferenceTrackingPolicy<> { using Type = ReferenceStatistics; };
+    //      }
+    //
+    //   #include <jni/jni.hpp>
+    //
+    // References created by calling JNIEnv directly, or passed to native methods by the JVM, are
+    // not tracked, and deleting them is ignored.
+
+    struct NullReferenceTracking
+       {
+        // Labels references created on this thread during its lifetime, so that they may be
+        // attributed to a call site in the report. Labels must be string literals, or otherwise
+        // outlive the Site.
+        struct Site
+           {
+            explicit Site(const char*) {}
+           };
+
+        static void Created(ReferenceKind, JNIFunction, const jobject*) {}
+        static void Deleted(ReferenceKind, const jobject*) {}
+        static void FramePushed() {}
+        static void FramePopped() {}
+        static void FrameReleased() {}
+       };
+
+    template < class = void >
+    struct ReferenceTrackingPolicy
+       {
+        using Type = NullReferenceTracking;
+       };
+
+
+    struct ReferenceCounts
+       {
+        std::uint64_t created = 0;
+        std::uint64_t live = 0;
+        std::uint64_t highWater = 0;
+        std::uint64_t leaked = 0;
+       };
+
+    // References created by one JNI function, under one Site label ("" if none).
+    struct ReferenceSiteStatistics
+       {
+        ReferenceKind kind;
+        JNIFunction function;
+        std::string site;
+        ReferenceCounts counts;
+       };
+
+    // For local references, `live` is summed over threads, while `highWater` is the most that were
+    // live at once on any one thread -- the figure to use for EnsureLocalCapacity or PushLocalFrame.
+    // For global and weak global references, counts are process-wide.
+    //
+    // A local reference is counted as leaked if it is still live when the local frame it was
+    // created in is popped, or when the thread that created it exits. One still live when a native
+    // method returns is released by the JVM, and is not counted as leaked. Global and weak global
+    // references are never counted as leaked; watch `live` instead.
+    struct ReferenceReport
+       {
+        std::array<ReferenceCounts, referenceKindCount> kinds {};
+        std::vector<ReferenceSiteStatistics> sites;
+       };
+
+    // A reference tracking policy that counts live references of each kind, both in total and
+    // for each call site, and records high-water marks and leaks. It is intended for debugging and
+    // capacity planning: each event takes a lock, and each local reference is recorded in a
+    // per-thread list.
+    class ReferenceStatistics
+       {
+        public:
+            // Called with the number of local references leaked from one site when a frame is
+            // popped or a thread exits. Called without holding any lock.
+            using LeakHandler = void (*)(const ReferenceSiteStatistics& site, std::uint64_t count);
+
+        private:
+            using SiteKey = std::tuple<ReferenceKind, JNIFunction, std::string>;
+
+            struct ThreadState;
+
+            struct Registry
+               {
+                std::mutex mutex;
+                std::map<SiteKey, std::size_t> siteIndices;
+                std::vector<ReferenceSiteStatistics> sites;
+                std::array<ReferenceCounts, referenceKindCount> kinds {};
+                std::unordered_multimap<const jobject*, std::size_t> globals;
+                std::vector<ThreadState*> threads;
+                std::atomic<LeakHandler> leakHandler { nullptr };
+               };
+
+            // Leaked, as threads may exit after static destruction.
+            static Registry& GetRegistry()
+               {
+                static Registry* registry = new Registry();
+                return *registry;
+               }
+
+            static void Add(ReferenceCounts& counts)
+               {
+                ++counts.created;
+                counts.highWater = std::max(counts.highWater, ++counts.live);
+               }
+
+            static void Remove(ReferenceCounts& counts, bool leaked)
+               {
+                --counts.live;
+                if (leaked)
+                    ++counts.leaked;
+               }
+
+            static void Fold(ReferenceCounts& total, const ReferenceCounts& counts)
+               {
+                total.created += counts.created;
+                total.live += counts.live;
+                total.highWater = std::max(total.highWater, counts.highWater);
+                total.leaked += counts.leaked;
+               }
+
+            // Requires the registry lock.
+            static std::size_t SiteIndex(Registry& registry, ReferenceKind kind, JNIFunction function, const char* label)
+               {
+                SiteKey key(kind, function, label ? label : "");
+                auto it = registry.siteIndices.find(key);
+                if (it != registry.siteIndices.end())
+                    return it->second;
+
+                const std::size_t index = registry.sites.size();
+                registry.sites.push_back({ kind, function, std::get<2>(key), ReferenceCounts() });
+                registry.siteIndices.emplace(std::move(key), index);
+                return index;
+               }
+
+            static const char*& Label()
+               {
+                static thread_local const char* label = nullptr;
+                return label;
+               }
+
+            using Leaks = std::map<std::size_t, std::uint64_t>;
+
+            static void Report(const Leaks& leaks)
+               {
+                Registry& registry = GetRegistry();
+                LeakHandler handler = registry.leakHandler.load();
+                if (!handler || leaks.empty())
+                    return;
+
+                std::vector<std::pair<ReferenceSiteStatistics, std::uint64_t>> sites;
+                   {
+                    std::lock_guard<std::mutex> lock(registry.mutex);
+                    for (const auto& leak : leaks)
+                        sites.emplace_back(registry.sites[leak.first], leak.second);
+                   }
+
+                for (const auto& site : sites)
+                    handler(site.first, site.second);
+               }
+
+            // Local references are recorded by the thread that creates them. Only that thread
+            // modifies its state; the mutex serializes it with Snapshot.
+            struct ThreadState
+               {
+                struct Entry
+                   {
+                    const jobject* reference;
+                    std::size_t site;
+                   };
+
+                std::mutex mutex;
+                std::vector<Entry> locals;
+                std::vector<std::size_t> frames;
+                std::vector<ReferenceCounts> sites;
+                ReferenceCounts total;
+                std::map<std::pair<JNIFunction, const char*>, std::size_t> siteCache;
+
+                ThreadState()
+                   {
+                    Registry& registry = GetRegistry();
+                    std::lock_guard<std::mutex> lock(registry.mutex);
+                    registry.threads.push_back(this);
+                   }
+
+                ~ThreadState()
+                   {
+                    Registry& registry = GetRegistry();
+                    Leaks leaks;
+
+                       {
+                        std::lock_guard<std::mutex> registryLock(registry.mutex);
+                        std::lock_guard<std::mutex> lock(mutex);
+
+                        RemoveFrom(0, &leaks);
+
+                        for (std::size_t i = 0; i < sites.size(); ++i)
+                            Fold(registry.sites[i].counts, sites[i]);
+                        Fold(registry.kinds[static_cast<std::size_t>(ReferenceKind::Local)], total);
+
+                        registry.threads.erase(std::find(registry.threads.begin(), registry.threads.end(), this));
+                       }
+
+                    Report(leaks);
+                   }
+
+                std::size_t LocalSite(JNIFunction function, const char* label)
+                   {
+                    auto key = std::make_pair(function, label);
+                    auto it = siteCache.find(key);
+                    if (it != siteCache.end())
+                        return it->second;
+
+                    Registry& registry = GetRegistry();
+                    std::lock_guard<std::mutex> lock(registry.mutex);
+                    const std::size_t index = SiteIndex(registry, ReferenceKind::Local, function, label);
+                    siteCache.emplace(key, index);
+                    return index;
+                   }
+
+                // Requires the thread lock. Removes the local references from `base` onward,
+                // counting them as leaked if `leaks` is given, and as released otherwise.
+                void RemoveFrom(std::size_t base, Leaks* leaks)
+                   {
+                    for (std::size_t i = base; i < locals.size(); ++i)
+                       {
+                        Remove(sites[locals[i].site], leaks != nullptr);
+                        Remove(total, leaks != nullptr);
+                        if (leaks)
+                            ++(*leaks)[locals[i].site];
+                       }
+                    locals.resize(base);
+                   }
+               };
+
+            static ThreadState& Thread()
+               {
+                static thread_local ThreadState state;
+                return state;
+               }
+
+        public:
+            class Site
+               {
+                private:
+                    const char* previous;
+
+                public:
+                    explicit Site(const char* label)
+                       : previous(Label())
+                       {
+                        Label() = label;
+                       }
+
+                    Site(const Site&) = delete;
+                    Site& operator=(const Site&) = delete;
+
+                    ~Site()
+                       {
+                        Label() = previous;
+                       }
+               };
+
+            static void Created(ReferenceKind kind, JNIFunction function, const jobject* reference)
+               {
+                if (!reference)
+                    return;
+
+                if (kind == ReferenceKind::Local)
+                   {
+                    ThreadState& thread = Thread();
+                    const std::size_t site = thread.LocalSite(function, Label());
+
+                    std::lock_guard<std::mutex> lock(thread.mutex);
+                    if (thread.sites.size() <= site)
+                        thread.sites.resize(site + 1);
+                    thread.locals.push_back({ reference, site });
+                    Add(thread.sites[site]);
+                    Add(thread.total);
+                    return;
+                   }
+
+                Registry& registry = GetRegistry();
+                std::lock_guard<std::mutex> lock(registry.mutex);
+                const std::size_t site = SiteIndex(registry, kind, function, Label());
+                registry.globals.emplace(reference, site);
+                Add(registry.sites[site].counts);
+                Add(registry.kinds[static_cast<std::size_t>(kind)]);
+               }
+
+            static void Deleted(ReferenceKind kind, const jobject* reference)
+               {
+                if (!reference)
+                    return;
+
+                if (kind == ReferenceKind::Local)
+                   {
+                    ThreadState& thread = Thread();
+                    std::lock_guard<std::mutex> lock(thread.mutex);
+
+                    // Local references are usually deleted in LIFO order.
+                    auto it = std::find_if(thread.locals.rbegin(), thread.locals.rend(),
+                        [&] (const ThreadState::Entry& entry) { return entry.reference == reference; });
+                    if (it == thread.locals.rend())
+                        return;
+
+                    const std::size_t index = static_cast<std::size_t>(std::distance(it, thread.locals.rend())) - 1;
+                    Remove(thread.sites[it->site], false);
+                    Remove(thread.total, false);
+                    thread.locals.erase(thread.locals.begin() + static_cast<std::ptrdiff_t>(index));
+
+                    for (std::size_t& base : thread.frames)
+                        if (base > index)
+                            --base;
+                    return;
+                   }
+
+                Registry& registry = GetRegistry();
+                std::lock_guard<std::mutex> lock(registry.mutex);
+                auto it = registry.globals.find(reference);
+                for (; it != registry.globals.end() && it->first == reference; ++it)
+                   {
+                    if (registry.sites[it->second].kind != kind)
+                        continue;
+                    Remove(registry.sites[it->second].counts, false);
+                    Remove(registry.kinds[static_cast<std::size_t>(kind)], false);
+                    registry.globals.erase(it);
+                    return;
+                   }
+               }
+
+            static void FramePushed()
+               {
+                ThreadState& thread = Thread();
+                std::lock_guard<std::mutex> lock(thread.mutex);
+                thread.frames.push_back(thread.locals.size());
+               }
+
+            static void FramePopped()
+               {
+                ThreadState& thread = Thread();
+                Leaks leaks;
+
+                   {
+                    std::lock_guard<std::mutex> lock(thread.mutex);
+                    if (thread.frames.empty())
+                        return;
+                    const std::size_t base = thread.frames.back();
+                    thread.frames.pop_back();
+                    thread.RemoveFrom(base, &leaks);
+                   }
+
+                Report(leaks);
+               }
+
+            static void FrameReleased()
+               {
+                ThreadState& thread = Thread();
+                std::lock_guard<std::mutex> lock(thread.mutex);
+                if (thread.frames.empty())
+                    return;
+                const std::size_t base = thread.frames.back();
+                thread.frames.pop_back();
+                thread.RemoveFrom(base, nullptr);
+               }
+
+            static void SetLeakHandler(LeakHandler handler)
+               {
+                GetRegistry().leakHandler.store(handler);
+               }
+
+            // Returns counts for each kind of reference, and for each site that has created at
+            // least one reference.
+            static ReferenceReport Snapshot()
+               {
+                Registry& registry = GetRegistry();
+                ReferenceReport report;
+
+                   {
+                    std::lock_guard<std::mutex> registryLock(registry.mutex);
+                    report.kinds = registry.kinds;
+                    report.sites = registry.sites;
+
+                    for (ThreadState* thread : registry.threads)
+                       {
+                        std::lock_guard<std::mutex> lock(thread->mutex);
+                        for (std::size_t i = 0; i < thread->sites.size(); ++i)
+                            Fold(report.sites[i].counts, thread->sites[i]);
+                        Fold(report.kinds[static_cast<std::size_t>(ReferenceKind::Local)], thread->total);
+                       }
+                   }
+
+                report.sites.erase(std::remove_if(report.sites.begin(), report.sites.end(),
+                    [] (const ReferenceSiteStatistics& s) { return s.counts.created == 0; }), report.sites.end());
+                return report;
+               }
+       };
+
+    inline void WriteJSON(std::ostream& out, const ReferenceCounts& counts)
+       {
+        out << "{\"created\":" << counts.created
+            << ",\"live\":" << counts.live
+            << ",\"highWater\":" << counts.highWater
+            << ",\"leaked\":" << counts.leaked << "}";
+       }
+
+    // Writes a report as a JSON object with per-kind totals and an array of sites.
+    inline void WriteJSON(std::ostream& out, const ReferenceReport& report)
+       {
+        out << "{\"kinds\":{";
+        for (std::size_t k = 0; k < referenceKindCount; ++k)
+           {
+            out << (k ? ",\n " : "\n ") << "\"" << Name(static_cast<ReferenceKind>(k)) << "\":";
+            WriteJSON(out, report.kinds[k]);
+           }
+        out << "},\n\"sites\":[";
+        for (std::size_t i = 0; i < report.sites.size(); ++i)
+           {
+            const ReferenceSiteStatistics& s = report.sites[i];
+            out << (i ? ",\n " : "\n ")
+                << "{\"kind\":\"" << Name(s.kind) << "\""
+                << ",\"function\":\"" << Name(s.function) << "\""
+                << ",\"site\":\"" << s.site << "\""
+                << ",\"counts\":";
+            WriteJSON(out, s.counts);
+            out << "}";
+           }
+        out << "\n]}\n";
+       }
+   }
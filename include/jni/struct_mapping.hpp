@@ -0,0 +1,146 @@
+#pragma once
+
+#include <jni/functions.hpp>
+#include <jni/class.hpp>
+#include <jni/object.hpp>
+#include <jni/constructor.hpp>
+#include <jni/type_signature.hpp>
+#include <jni/make.hpp>
+#include <jni/npe.hpp>
+
+#include <array>
+#include <initializer_list>
+#include <tuple>
+#include <utility>
+
+namespace jni
+   {
+    // Specialize StructMapping to declare a correspondence between the members of a C++ struct and
+    // the fields of a Java class:
+    //
+    //   template <> struct jni::StructMapping<Point>
+    //      {
+    //       using TagType = PointTag;
+    //
+    //       static auto Fields()
+    //          {
+    //           return std::make_tuple(jni::MapField(&Point::x, "x"),
+    //                                  jni::MapField(&Point::y, "y"));
+    //          }
+    //      };
+    //
+    // Mapped members must have jni.hpp primitive types. Given a mapping, jni.hpp provides
+    // `Make<Point>(env, object)` and `Make<Object<PointTag>>(env, point)`, as well as GetFields and
+    // SetFields for existing structs and objects. Field IDs are looked up once, and all the fields
+    // are read or written with a single exception check at the end.
+    template < class Struct >
+    struct StructMapping;
+
+    template < class Struct, class T >
+    struct FieldMapping
+       {
+        static_assert(IsPrimitive<T>::value, "mapped members must have primitive types");
+
+        T Struct::* member;
+        const char* name;
+       };
+
+    template < class Struct, class T >
+    constexpr FieldMapping<Struct, T> MapField(T Struct::* member, const char* name)
+       {
+        return { member, name };
+       }
+
+
+    template < class Struct, class = std::make_index_sequence<std::tuple_size<decltype(StructMapping<Struct>::Fields())>::value> >
+    class StructFields;
+
+    template < class Struct, std::size_t... Is >
+    class StructFields< Struct, std::index_sequence<Is...> >
+       {
+        private:
+            using Mapping = StructMapping<Struct>;
+            using TagType = typename Mapping::TagType;
+            using FieldIDs = std::array<jfieldID*, sizeof...(Is)>;
+
+            template < class T >
+            static jfieldID* GetID(JNIEnv& env, const FieldMapping<Struct, T>& mapping)
+               {
+                return &GetFieldID(env, *Class<TagType>::Singleton(env), mapping.name, TypeSignature<T>()());
+               }
+
+            static const FieldIDs& IDs(JNIEnv& env)
+               {
+                static const auto fields = Mapping::Fields();
+                static const FieldIDs ids {{ GetID(env, std::get<Is>(fields))... }};
+                return ids;
+               }
+
+            template < class T >
+            static int GetOne(JNIEnv& env, jobject* obj, jfieldID* id, const FieldMapping<Struct, T>& mapping, Struct& s)
+               {
+                Instrumentation::Call call(env, JNIFunction::GetField);
+                s.*(mapping.member) = Wrap<T>((env.*(TypedMethods<T>::GetField))(Unwrap(obj), Unwrap(*id)));
+                return 0;
+               }
+
+            template < class T >
+            static int SetOne(JNIEnv& env, jobject* obj, jfieldID* id, const FieldMapping<Struct, T>& mapping, const Struct& s)
+               {
+                Instrumentation::Call call(env, JNIFunction::SetField);
+                (env.*(TypedMethods<T>::SetField))(Unwrap(obj), Unwrap(*id), Unwrap(s.*(mapping.member)));
+                return 0;
+               }
+
+        public:
+            static void Get(JNIEnv& env, jobject& obj, Struct& s)
+               {
+                static const auto fields = Mapping::Fields();
+                const FieldIDs& ids = IDs(env);
+                (void)std::initializer_list<int> { GetOne(env, &obj, ids[Is], std::get<Is>(fields), s)... };
+                CheckJavaException(env);
+               }
+
+            static void Set(JNIEnv& env, jobject& obj, const Struct& s)
+               {
+                static const auto fields = Mapping::Fields();
+                const FieldIDs& ids = IDs(env);
+                (void)std::initializer_list<int> { SetOne(env, &obj, ids[Is], std::get<Is>(fields), s)... };
+                CheckJavaException(env);
+               }
+       };
+
+
+    template < class Struct >
+    void GetFields(JNIEnv& env, const Object<typename StructMapping<Struct>::TagType>& object, Struct& s)
+       {
+        StructFields<Struct>::Get(env, SafeDereference(env, object.get()), s);
+       }
+
+    template < class Struct >
+    void SetFields(JNIEnv& env, const Object<typename StructMapping<Struct>::TagType>& object, const Struct& s)
+       {
+        StructFields<Struct>::Set(env, SafeDereference(env, object.get()), s);
+       }
+
+    template < class Struct >
+    Struct MakeAnything(ThingToMake<Struct>, JNIEnv& env, const Object<typename StructMapping<Struct>::TagType>& object)
+       {
+        Struct result {};
+        GetFields(env, object, result);
+        return result;
+       }
+
+    // The Java class must have an accessible no-argument constructor.
+    template < class Tag, class Struct >
+    auto MakeAnything(ThingToMake<Object<Tag>>, JNIEnv& env, const Struct& s)
+       -> std::enable_if_t< std::is_same<typename StructMapping<Struct>::TagType, Tag>::value, Local<Object<Tag>> >
+       {
+        static auto& klass = Class<Tag>::Singleton(env);
+        static auto constructor = klass.template GetConstructor<>(env);
+
+        Local<Object<Tag>> result = klass.New(env, constructor);
+        SetFields(env, result, s);
+        return result;
+       }
+   }
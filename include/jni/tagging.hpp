@@ -89,6 +89,13 @@ namespace jni
          using UntaggedType = jarray<jobject>;
         };
 
+    template < class E >
+    struct TagTraits< ArrayTag<Array<E>> >
+        {
+         using SuperType = Object<ObjectTag>;
+         using UntaggedType = jarray<jobject>;
+        };
+
 
     template < class T >
     auto Tag(JNIEnv&, T primitive)
@@ -0,0 +1,303 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace jni
+   {
+    // The wrappers produced by MakeNativeMethod construct a `Tracing::Scope` for the duration of
+    // each call from Java, passing the name of the native method. By default, Tracing is
+    // NullTracing, which does nothing, and compiles away entirely; noexcept native methods, which
+    // otherwise need no wrapper, are registered directly, unless a ReferenceTracking policy is in
+    // use. As with InstrumentationPolicy, to use another policy, specialize TracingPolicy after
+    // including this header, and before including any other jni.hpp header:
+    //
+    //   #include <jni/tracing.hpp>
+    //
+    //   namespace jni
+    //      {
+    //       template <> struct TracingPolicy<> { using Type = NativeMethodTracer; };
+    //      }
+    //
+    //   #include <jni/jni.hpp>
+    //
+    // The wrapper for a given function or lambda type is shared by every registration of it, so
+    // if one is registered under several names, its calls are traced under the first.
+    //
+    // A policy's Scope must not throw: noexcept native methods are wrapped without a try block.
+    //
+    // Critical native methods are always registered directly, and are not traced.
+
+    struct NullTracing
+       {
+        struct Scope
+           {
+            explicit Scope(const char*) {}
+           };
+       };
+
+    template < class = void >
+    struct TracingPolicy
+       {
+        using Type = NullTracing;
+       };
+
+
+    struct NativeTraceEvent
+       {
+        const char* name;
+        std::uint32_t thread;
+        std::int64_t begin;   // Nanoseconds since the tracer was first used.
+        std::int64_t end;
+       };
+
+    // A tracing policy that records the start and end time of sampled native method calls into a
+    // ring buffer for each thread. Recording takes only the owning thread's lock, so threads do not
+    // contend; calls that are not sampled cost a thread-local counter increment.
+    class NativeMethodTracer
+       {
+        private:
+            using Clock = std::chrono::steady_clock;
+
+            class ThreadBuffer;
+
+            struct Registry
+               {
+                std::mutex mutex;
+                std::vector<ThreadBuffer*> threads;
+                std::vector<NativeTraceEvent> exited;
+                std::uint32_t nextThread = 1;
+                std::atomic<std::uint32_t> samplingInterval { 1 };
+                std::atomic<std::size_t> capacity { 8192 };
+                const Clock::time_point origin = Clock::now();
+               };
+
+            // Leaked, as threads may exit after static destruction.
+            static Registry& GetRegistry()
+               {
+                static Registry* registry = new Registry();
+                return *registry;
+               }
+
+            // Constructed on a thread's first traced call, so construction does no work that could
+            // throw; the events are allocated, and the buffer registered, when the first sampled
+            // call ends.
+            class ThreadBuffer
+               {
+                private:
+                    std::vector<NativeTraceEvent> events;
+                    std::size_t next = 0;
+                    bool wrapped = false;
+
+                public:
+                    std::mutex mutex;
+                    std::uint32_t id = 0;
+                    std::uint32_t countdown = 0;
+
+                    ThreadBuffer() = default;
+
+                    ~ThreadBuffer()
+                       {
+                        if (events.empty())
+                            return;
+
+                        Registry& registry = GetRegistry();
+                        std::lock_guard<std::mutex> lock(registry.mutex);
+                        AppendTo(registry.exited);
+
+                        // Retain at most one buffer's worth of events from exited threads.
+                        const std::size_t limit = registry.capacity.load();
+                        if (registry.exited.size() > limit)
+                            registry.exited.erase(registry.exited.begin(), registry.exited.end() - static_cast<std::ptrdiff_t>(limit));
+
+                        registry.threads.erase(std::find(registry.threads.begin(), registry.threads.end(), this));
+                       }
+
+                    // Allocates and registers the buffer, if that has not been done. Must not be
+                    // called holding the lock. Returns false, and the event should be dropped, on
+                    // failure.
+                    bool Reserve() noexcept
+                       {
+                        if (!events.empty())
+                            return true;
+
+                        try
+                           {
+                            Registry& registry = GetRegistry();
+                            std::lock_guard<std::mutex> lock(registry.mutex);
+                            std::vector<NativeTraceEvent> allocated(std::max<std::size_t>(registry.capacity.load(), 1));
+                            registry.threads.push_back(this);
+                            id = registry.nextThread++;
+                            events.swap(allocated);
+                            return true;
+                           }
+                        catch (...)
+                           {
+                            return false;
+                           }
+                       }
+
+                    // Requires the lock, and a successful Reserve.
+                    void Record(const NativeTraceEvent& event)
+                       {
+                        events[next] = event;
+                        if (++next == events.size())
+                           {
+                            next = 0;
+                            wrapped = true;
+                           }
+                       }
+
+                    // Requires the lock. Appends events oldest first.
+                    void AppendTo(std::vector<NativeTraceEvent>& out) const
+                       {
+                        if (wrapped)
+                            out.insert(out.end(), events.begin() + static_cast<std::ptrdiff_t>(next), events.end());
+                        out.insert(out.end(), events.begin(), events.begin() + static_cast<std::ptrdiff_t>(next));
+                       }
+
+                    // Requires the lock.
+                    void Clear()
+                       {
+                        next = 0;
+                        wrapped = false;
+                       }
+               };
+
+            static ThreadBuffer& Buffer()
+               {
+                static thread_local ThreadBuffer buffer;
+                return buffer;
+               }
+
+            static std::int64_t Now()
+               {
+                return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - GetRegistry().origin).count();
+               }
+
+        public:
+            class Scope
+               {
+                private:
+                    const char* name = nullptr;
+                    std::int64_t begin = 0;
+
+                public:
+                    // Does not throw. A call that can't be recorded is skipped.
+                    explicit Scope(const char* n) noexcept
+                       {
+                        try
+                           {
+                            ThreadBuffer& buffer = Buffer();
+                            if (buffer.countdown > 0)
+                               {
+                                --buffer.countdown;
+                                return;
+                               }
+
+                            const std::uint32_t interval = GetRegistry().samplingInterval.load(std::memory_order_relaxed);
+                            if (interval == 0)
+                                return;
+
+                            buffer.countdown = interval - 1;
+                            name = n;
+                            begin = Now();
+                           }
+                        catch (...)
+                           {
+                            name = nullptr;
+                           }
+                       }
+
+                    Scope(const Scope&) = delete;
+                    Scope& operator=(const Scope&) = delete;
+
+                    ~Scope()
+                       {
+                        if (!name)
+                            return;
+
+                        const std::int64_t end = Now();
+                        ThreadBuffer& buffer = Buffer();
+                        if (!buffer.Reserve())
+                            return;
+
+                        std::lock_guard<std::mutex> lock(buffer.mutex);
+                        buffer.Record({ name, buffer.id, begin, end });
+                       }
+               };
+
+            // Record one in every `interval` calls on each thread; 0 disables recording. The
+            // default is 1, recording every call.
+            static void SetSamplingInterval(std::uint32_t interval)
+               {
+                GetRegistry().samplingInterval.store(interval);
+               }
+
+            // The number of events each thread's ring buffer holds before overwriting the oldest.
+            // Applies to threads that record their first event after the call. The default is 8192.
+            static void SetBufferCapacity(std::size_t capacity)
+               {
+                GetRegistry().capacity.store(capacity);
+               }
+
+            // Returns the recorded events of all threads, including those that have exited.
+            static std::vector<NativeTraceEvent> Events()
+               {
+                Registry& registry = GetRegistry();
+                std::lock_guard<std::mutex> registryLock(registry.mutex);
+
+                std::vector<NativeTraceEvent> result(registry.exited);
+                for (ThreadBuffer* thread : registry.threads)
+                   {
+                    std::lock_guard<std::mutex> lock(thread->mutex);
+                    thread->AppendTo(result);
+                   }
+                return result;
+               }
+
+            static void Clear()
+               {
+                Registry& registry = GetRegistry();
+                std::lock_guard<std::mutex> registryLock(registry.mutex);
+
+                registry.exited.clear();
+                for (ThreadBuffer* thread : registry.threads)
+                   {
+                    std::lock_guard<std::mutex> lock(thread->mutex);
+                    thread->Clear();
+                   }
+               }
+       };
+
+    // Writes events in the Chrome trace event format, as complete ("X") events, which can be
+    // opened with chrome://tracing or the Perfetto UI.
+    inline void WriteChromeTrace(std::ostream& out, const std::vector<NativeTraceEvent>& events)
+       {
+        const auto flags = out.flags();
+        const auto precision = out.precision();
+        out.setf(std::ios::fixed, std::ios::floatfield);
+        out.precision(3);
+
+        out << "{\"traceEvents\":[";
+        for (std::size_t i = 0; i < events.size(); ++i)
+           {
+            const NativeTraceEvent& e = events[i];
+            out << (i ? ",\n " : "\n ")
+                << "{\"name\":\"" << e.name << "\",\"cat\":\"jni\",\"ph\":\"X\""
+                << ",\"ts\":" << static_cast<double>(e.begin) / 1000.0
+                << ",\"dur\":" << static_cast<double>(e.end - e.begin) / 1000.0
+                << ",\"pid\":1,\"tid\":" << e.thread << "}";
+           }
+        out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+
+        out.flags(flags);
+        out.precision(precision);
+       }
+   }
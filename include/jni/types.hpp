@@ -79,6 +79,16 @@ namespace jni
         R (*fnPtr)(JNIEnv*, jobject*, Args...);
        };
 
+    // A "critical" native method, as used with Android's @CriticalNative annotation: it receives
+    // neither a JNIEnv nor a jclass, and its parameter and result types must be primitive.
+    template < class R, class... Args >
+    struct JNINativeMethod< R (Args...) >
+       {
+        const char* name;
+        const char* signature;
+        R (*fnPtr)(Args...);
+       };
+
     enum version : jint
        {
         jni_version_1_1 = version(JNI_VERSION_1_1),
@@ -151,6 +151,14 @@ namespace jni
         return t.release();
        }
 
+    // Ownership of a local reference returned from a native method passes to the JVM.
+    template < class T >
+    auto ReleaseUnique(Local<T>&& t)
+       {
+        ReferenceTracking::Deleted(ReferenceKind::Local, t.get());
+        return t.release();
+       }
+
 
     template < template < RefDeletionMethod > class Deleter, class T >
     auto NewGlobal(JNIEnv& env, const T& t)
@@ -173,7 +181,9 @@ namespace jni
     template < template < RefDeletionMethod > class Deleter, class T, template < RefDeletionMethod > class WeakDeleter >
     Global<T, Deleter> NewGlobal(JNIEnv& env, const Weak<T, WeakDeleter>& t)
        {
+        Instrumentation::Call call(env, JNIFunction::NewGlobalRef);
         jobject* obj = Wrap<jobject*>(env.NewGlobalRef(Unwrap(t->get())));
+        ReferenceTracking::Created(ReferenceKind::Global, JNIFunction::NewGlobalRef, obj);
         CheckJavaException(env);
         return Global<T, Deleter>(env, obj);
        }
@@ -213,8 +223,10 @@ namespace jni
     template < class T, template < RefDeletionMethod > class WeakDeleter >
     Local<T> NewLocal(JNIEnv& env, const Weak<T, WeakDeleter>& t)
        {
-        jobject* obj = Wrap<jobject*>(env.NewLocalRef(Unwrap(t->get())));
+        Instrumentation::Call call(env, JNIFunction::NewLocalRef);
+        jobject* obj = Wrap<jobject*>(env.NewLocalRef(Unwrap(t.get())));
+        ReferenceTracking::Created(ReferenceKind::Local, JNIFunction::NewLocalRef, obj);
         CheckJavaException(env);
-        return Local<T>(env, obj);
+        return Local<T>(env, reinterpret_cast<typename T::UntaggedType*>(obj));
        }
    }
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <jni/functions.hpp>
+#include <jni/object.hpp>
+#include <jni/unique.hpp>
+#include <jni/advanced_ownership.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace jni
+   {
+    /*
+        A cache of Java objects keyed by native values, which holds its objects by weak global
+        references, so that it doesn't keep alive objects that are otherwise unreachable.
+
+        `Get` promotes the weak reference to a local reference, returning an empty result (and
+        removing the entry) if the object has been collected. Promotion has the semantics of
+        `NewLocal(env, weak)`: an object may still be returned while it is being finalized. Where
+        that matters, cache `WeakReference<T>` values in a map instead.
+
+        Entries whose objects have been collected are also removed incrementally: each `Put` checks
+        up to `sweepStep` further entries, in turn, so that the cost of sweeping is amortized over
+        insertions. `Sweep` checks every entry.
+
+        All member functions may be called concurrently. They, and the destructor, must be called on
+        threads with a JVM attachment.
+    */
+    template < class Key, class T = Object<>, class Hash = std::hash<Key> >
+    class WeakCache
+       {
+        private:
+            using Reference = Weak<T, EnvGettingDeleter>;
+
+            struct Entry
+               {
+                Key key;
+                Reference reference;
+               };
+
+            // Entries are kept in a vector, indexed by the map, so that the sweep can resume from
+            // a position that removals don't invalidate.
+            std::vector<Entry> entries;
+            std::unordered_map<Key, std::size_t, Hash> indices;
+            std::size_t cursor = 0;
+            const std::size_t sweepStep;
+            mutable std::mutex mutex;
+
+            static bool Cleared(JNIEnv& env, const Reference& reference)
+               {
+                return IsSameObject(env, reference.get(), nullptr);
+               }
+
+            // Requires the lock. Moves the last entry into the removed entry's place.
+            void Remove(std::size_t index)
+               {
+                indices.erase(entries[index].key);
+                if (index != entries.size() - 1)
+                   {
+                    entries[index] = std::move(entries.back());
+                    indices[entries[index].key] = index;
+                   }
+                entries.pop_back();
+               }
+
+            // Requires the lock.
+            std::size_t SweepSome(JNIEnv& env, std::size_t count)
+               {
+                std::size_t removed = 0;
+                for (; count > 0 && !entries.empty(); --count)
+                   {
+                    if (cursor >= entries.size())
+                        cursor = 0;
+
+                    if (Cleared(env, entries[cursor].reference))
+                       {
+                        Remove(cursor);
+                        ++removed;
+                       }
+                    else
+                       {
+                        ++cursor;
+                       }
+                   }
+                return removed;
+               }
+
+        public:
+            explicit WeakCache(std::size_t step = 2)
+               : sweepStep(step)
+               {}
+
+            WeakCache(const WeakCache&) = delete;
+            WeakCache& operator=(const WeakCache&) = delete;
+
+            // Returns a local reference to the cached object, or an empty result if there is none.
+            Local<T> Get(JNIEnv& env, const Key& key)
+               {
+                std::lock_guard<std::mutex> lock(mutex);
+
+                auto it = indices.find(key);
+                if (it == indices.end())
+                    return Local<T>();
+
+                Local<T> result = NewLocal(env, entries[it->second].reference);
+                if (!result)
+                    Remove(it->second);
+                return result;
+               }
+
+            // Caches `object` under `key`, replacing any existing entry.
+            void Put(JNIEnv& env, const Key& key, const T& object)
+               {
+                Reference reference = NewWeak<EnvGettingDeleter>(env, object);
+
+                std::lock_guard<std::mutex> lock(mutex);
+
+                auto it = indices.find(key);
+                if (it != indices.end())
+                   {
+                    entries[it->second].reference = std::move(reference);
+                   }
+                else
+                   {
+                    entries.push_back({ key, std::move(reference) });
+                    indices.emplace(key, entries.size() - 1);
+                   }
+
+                SweepSome(env, sweepStep);
+               }
+
+            // Removes the entry for `key`. Returns false if there was none.
+            bool Erase(const Key& key)
+               {
+                std::lock_guard<std::mutex> lock(mutex);
+
+                auto it = indices.find(key);
+                if (it == indices.end())
+                    return false;
+
+                Remove(it->second);
+                return true;
+               }
+
+            // Removes all entries whose objects have been collected. Returns the number removed.
+            std::size_t Sweep(JNIEnv& env)
+               {
+                std::lock_guard<std::mutex> lock(mutex);
+                cursor = 0;
+                return SweepSome(env, entries.size());
+               }
+
+            // The number of entries, including those whose objects have been collected but which
+            // have not yet been removed.
+            std::size_t Size() const
+               {
+                std::lock_guard<std::mutex> lock(mutex);
+                return entries.size();
+               }
+       };
+   }
@@ -3,6 +3,11 @@
 #include <jni/class.hpp>
 #include <jni/object.hpp>
 
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
 namespace jni
    {
     struct WeakReferenceTag { static constexpr auto Name() { return "java/lang/ref/WeakReference"; } };
@@ -17,24 +22,75 @@ namespace jni
         private:
             Global<Object<WeakReferenceTag>, Deleter> reference;
 
+            // A JNI weak global reference to the same referent. It is cleared no earlier than the
+            // WeakReference, so once it is cleared, so is the WeakReference; it's used only to skip
+            // calling `get()` in that case, never to promote.
+            Weak<T, Deleter> shadow;
+
+            static const auto& GetMethod(JNIEnv& env)
+               {
+                static auto& klass = Class<WeakReferenceTag>::Singleton(env);
+                static auto get = klass.template GetMethod<Object<> ()>(env, "get");
+                return get;
+               }
+
         public:
             WeakReference(JNIEnv& env, const T& referent)
                {
                 static auto& klass = Class<WeakReferenceTag>::Singleton(env);
                 static auto constructor = klass.GetConstructor<Object<>>(env);
                 reference = NewGlobal<Deleter>(env, klass.New(env, constructor, referent));
+                shadow = NewWeak<Deleter>(env, referent);
                }
 
-            Local<T> get(JNIEnv& env)
+            Local<T> get(JNIEnv& env) const
                {
                 if (!reference)
                    {
                     return Local<T>();
                    }
 
-                static auto& klass = Class<WeakReferenceTag>::Singleton(env);
-                static auto get = klass.template GetMethod<Object<> ()>(env, "get");
-                return Local<T>(env, reinterpret_cast<typename T::UntaggedType*>(reference.Call(env, get).release()));
+                return Local<T>(env, reinterpret_cast<typename T::UntaggedType*>(reference.Call(env, GetMethod(env)).release()));
+               }
+
+            // Returns true if the referent has certainly been collected, without calling into Java.
+            // A false result does not guarantee that `get` will return a non-empty result.
+            bool IsCleared(JNIEnv& env) const
+               {
+                return !reference || IsSameObject(env, shadow.get(), nullptr);
+               }
+
+            // Like `get`, but returns an empty result without calling `get()` if IsCleared.
+            // Preferable when many references are expected to have been cleared.
+            Local<T> TryGet(JNIEnv& env) const
+               {
+                return IsCleared(env) ? Local<T>() : get(env);
                }
        };
+
+    // Calls `f` with each referent of `references` that has not been collected. Referents are obtained
+    // in batches within a local frame, so that their references are released by one PopLocalFrame per
+    // batch rather than a DeleteLocalRef each. `f` is called with a borrowed `const T&`, and may create
+    // up to `extraLocalsPerElement` further local references per referent without releasing them.
+    template < class T, template < RefDeletionMethod > class Deleter, class F >
+    void GetAll(JNIEnv& env, const std::vector<WeakReference<T, Deleter>>& references, F&& f, jint extraLocalsPerElement = 0)
+       {
+        static const std::size_t batchSize = 64;
+
+        for (std::size_t start = 0; start < references.size(); start += batchSize)
+           {
+            const std::size_t end = std::min(references.size(), start + batchSize);
+            UniqueLocalFrame frame = PushLocalFrame(env, static_cast<jint>(end - start) * (1 + extraLocalsPerElement));
+
+            for (std::size_t i = start; i < end; ++i)
+               {
+                if (auto* referent = references[i].get(env).release())
+                   {
+                    f(T(referent));
+                   }
+               }
+
+            ReleaseLocalFrame(env, std::move(frame));
+           }
+       }
    }
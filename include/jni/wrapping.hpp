@@ -142,6 +142,15 @@ namespace jni
            }
        };
 
+    template < class R, class... Args >
+    struct Wrapper< JNINativeMethod< R (Args...) > >
+       {
+        ::JNINativeMethod Unwrap(JNINativeMethod<R (Args...)> method) const
+           {
+            return { const_cast<char*>(method.name), const_cast<char*>(method.signature), reinterpret_cast<void*>(method.fnPtr) };
+           }
+       };
+
 
     template <>
     struct Wrapper<version>
@@ -0,0 +1,41 @@
+#!/usr/bin/env bash
+# Compiles bench/codegen.cpp at -O2, and checks that each `jnihpp_<name>` function compiles to
+# no more instructions than the corresponding `raw_<name>` function. Instructions that the compiler
+# moves to a separate section for unlikely code (e.g. `.text.unlikely`, holding exception paths)
+# are not counted.
+#
+# Usage: CXX=... misc/codegen-check.sh [extra compiler flags, e.g. -Itest/openjdk]
+set -euo pipefail
+
+CXX="${CXX:-c++}"
+ASM="$(mktemp)"
+trap 'rm -f "$ASM"' EXIT
+
+"$CXX" --std=c++14 -Iinclude -O2 -DNDEBUG "$@" -S -o "$ASM" bench/codegen.cpp
+
+COUNTS="$(awk '
+    /^_?(raw|jnihpp)_[a-z_]+:/          { name = $1; sub(/^_/, "", name); sub(/:$/, "", name); count[name] = 0; hot = 1; next }
+    /^[ \t]+\.section.*(unlikely|cold)/ { hot = 0; next }
+    /^[ \t]+\.(text|section)/           { hot = 1; next }
+    /^[ \t]+\.size/                     { name = ""; next }
+    name != "" && hot && /^[ \t]+[a-z]/ { count[name]++ }
+    END { for (n in count) print n, count[n] }
+' "$ASM" | sort)"
+
+status=0
+while read -r name raw; do
+    case "$name" in raw_*) ;; *) continue ;; esac
+    op="${name#raw_}"
+    wrapped="$(awk -v n="jnihpp_$op" '$1 == n { print $2 }' <<< "$COUNTS")"
+    if [ -z "$wrapped" ]; then
+        echo "MISSING  $op: no jnihpp_$op"
+        status=1
+    elif [ "$wrapped" -gt "$raw" ]; then
+        echo "FAIL     $op: raw $raw, jni.hpp $wrapped instructions"
+        status=1
+    else
+        echo "OK       $op: raw $raw, jni.hpp $wrapped instructions"
+    fi
+done <<< "$COUNTS"
+
+exit $status
@@ -1,9 +1,17 @@
 #include "test.hpp"
 
 #include <jni/jni.hpp>
+#include <jni/io.hpp>
+#include <jni/global_ref_pool.hpp>
+#include <jni/handle_table.hpp>
+#include <jni/weak_cache.hpp>
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
+#include <thread>
+
+#include <unistd.h>
 
 namespace
    {
@@ -11,6 +19,8 @@ namespace
 
     void Method(jni::JNIEnv&, jni::Object<Test>&) {}
     int StaticMethod(jni::JNIEnv&, jni::Class<Test>&) { return 0; }
+    jni::jboolean NoexceptMethod(jni::JNIEnv&, jni::Object<Test>&, jni::jboolean b) noexcept { return b; }
+    jni::jdouble CriticalMethod(jni::jdouble a, jni::jint b) { return a * b; }
 
     struct Peer
        {
@@ -22,6 +32,20 @@ namespace
         static void Static(jni::JNIEnv&, Peer&) {}
        };
 
+    struct PooledPeer
+       {
+        PooledPeer(jni::JNIEnv&, jni::jint v) : value(v) {}
+        jni::jint value;
+       };
+
+    struct PointTag { static constexpr auto Name() { return "mapbox/com/Point"; } };
+
+    struct Point
+       {
+        jni::jint x;
+        jni::jdouble y;
+       };
+
     struct Base {};
     struct Derived
        {
@@ -29,6 +53,22 @@ namespace
        };
    }
 
+namespace jni
+   {
+    template <> struct NativePeerStorage<PooledPeer> : PooledPeerStorage<PooledPeer> {};
+
+    template <> struct StructMapping<Point>
+       {
+        using TagType = PointTag;
+
+        static auto Fields()
+           {
+            return std::make_tuple(MapField(&Point::x, "x"),
+                                   MapField(&Point::y, "y"));
+           }
+       };
+   }
+
 template < char... Cs >
 bool operator==(const jni::StringLiteral<Cs...>& a, const char * b)
    {
@@ -714,6 +754,10 @@ int main()
         reinterpret_cast<void (*)(JNIEnv*, jobject)>(throwsUnknown.fnPtr)(&env, nullptr);
         assert(lastExceptionMessage == std::string("unknown native exception"));
 
+        auto noexceptTrue = jni::MakeNativeMethod("noexceptTrue", [] (JNIEnv&, ObjectOrClass&, jni::jboolean b) noexcept { return b; });
+        assert(noexceptTrue.signature == std::string("(Z)Z"));
+        assert(reinterpret_cast<jboolean (*)(JNIEnv*, jobject, jboolean)>(noexceptTrue.fnPtr)(&env, nullptr, JNI_TRUE) == JNI_TRUE);
+
         auto javaException = jni::MakeNativeMethod("javaException", [] (JNIEnv&, ObjectOrClass&) { jni::ThrowNew(env, jni::FindClass(env, "java/lang/Error"), "Java exception"); });
         lastExceptionMessage.clear();
         reinterpret_cast<void (*)(JNIEnv*, jobject)>(javaException.fnPtr)(&env, nullptr);
@@ -816,6 +860,28 @@ int main()
     jni::MakeNativeMethod<decltype(&Method), &Method>("name");
     jni::MakeNativeMethod<decltype(&StaticMethod), &StaticMethod>("name");
 
+    auto noexceptMethod = jni::MakeNoexceptNativeMethod<decltype(&NoexceptMethod), &NoexceptMethod>("noexceptMethod");
+    assert(noexceptMethod.signature == std::string("(Z)Z"));
+    assert(noexceptMethod.fnPtr(&env, nullptr, JNI_TRUE) == JNI_TRUE);
+
+
+    /// CriticalNativeMethod
+
+    auto criticalMethod = jni::MakeCriticalNativeMethod<decltype(&CriticalMethod), &CriticalMethod>("critical");
+    assert(criticalMethod.signature == std::string("(DI)D"));
+    assert(criticalMethod.fnPtr(1.5, 2) == 3.0);
+
+    auto criticalLambda = jni::MakeCriticalNativeMethod("critical", [] (jni::jint a, jni::jint b) { return a + b; });
+    assert(criticalLambda.signature == std::string("(II)I"));
+    assert(criticalLambda.fnPtr(2, 3) == 5);
+
+    auto criticalVoid = jni::MakeCriticalNativeMethod("critical", [] () {});
+    assert(criticalVoid.signature == std::string("()V"));
+
+    // None of these should compile:
+//  jni::MakeCriticalNativeMethod("critical", [] (jni::JNIEnv&, jni::Class<Test>&) {});
+//  jni::MakeCriticalNativeMethod("critical", [] (jni::jobject*) {});
+
 
     static JNINativeMethod methods[6];
 
@@ -871,5 +937,1196 @@ int main()
     assert(methods[0].name == std::string("initialize"));
     assert(methods[1].name == std::string("finalize"));
 
+    jni::RegisterNativePeer<PooledPeer>(env, testClass, "peer",
+        jni::MakePeer<PooledPeer, jni::jint>,
+        "initialize",
+        "finalize");
+
+    assert(methods[0].signature == std::string("(I)V"));
+
+
+    /// PooledPeerStorage
+
+    using PooledStorage = jni::NativePeerStorage<PooledPeer>;
+
+    auto pooled = jni::MakePeer<PooledPeer, jni::jint>(env, 42);
+    PooledPeer* pooledAddress = pooled.get();
+    jni::jlong pooledHandle = PooledStorage::Handle(pooled);
+    assert(PooledStorage::Get(pooledHandle) == pooledAddress);
+    assert(PooledStorage::Get(pooledHandle)->value == 42);
+    assert(PooledStorage::Get(0) == nullptr);
+
+    pooled.release();
+    PooledStorage::Reclaim(pooledHandle).reset();
+    assert(PooledStorage::Get(pooledHandle) == nullptr);
+
+    auto reused = jni::MakePeer<PooledPeer, jni::jint>(env, 43);
+    assert(reused.get() == pooledAddress);
+    assert(PooledStorage::Handle(reused) != pooledHandle);
+    assert(PooledStorage::Get(pooledHandle) == nullptr);
+    assert(PooledStorage::Get(PooledStorage::Handle(reused))->value == 43);
+
+    jni::RegisterNativePeer<PooledPeer>(env, testClass, "peer",
+        jni::MakePeer<PooledPeer, jni::jint>,
+        "initialize",
+        jni::NativePeerDisposers { "dispose", "disposeAll" });
+
+    assert(methods[1].name == std::string("dispose"));
+    assert(methods[1].signature == std::string("(J)V"));
+    assert(methods[2].name == std::string("disposeAll"));
+    assert(methods[2].signature == std::string("([J)V"));
+
+    jni::jlong reusedHandle = PooledStorage::Handle(reused);
+    reused.release();
+    reinterpret_cast<void (*)(JNIEnv*, jclass, jlong)>(methods[1].fnPtr)(&env, jni::Unwrap(classValue.Ptr()), reusedHandle);
+    assert(PooledStorage::Get(reusedHandle) == nullptr);
+
+    static jni::jlong disposeAllHandles[2];
+    static Testable<jni::jarray<jni::jlong>> disposeAllArrayValue;
+    auto first = jni::MakePeer<PooledPeer, jni::jint>(env, 1);
+    auto second = jni::MakePeer<PooledPeer, jni::jint>(env, 2);
+    disposeAllHandles[0] = PooledStorage::Handle(first);
+    disposeAllHandles[1] = PooledStorage::Handle(second);
+    first.release();
+    second.release();
+
+    env.fns->GetArrayLength = [] (JNIEnv*, jarray array) -> jsize
+       {
+        assert(array == jni::Unwrap(disposeAllArrayValue.Ptr()));
+        return 2;
+       };
+
+    env.fns->GetLongArrayRegion = [] (JNIEnv*, jlongArray, jsize start, jsize len, jlong* buf)
+       {
+        std::copy(disposeAllHandles + start, disposeAllHandles + start + len, buf);
+       };
+
+    reinterpret_cast<void (*)(JNIEnv*, jclass, jlongArray)>(methods[2].fnPtr)(&env, jni::Unwrap(classValue.Ptr()), jni::Unwrap(disposeAllArrayValue.Ptr()));
+    assert(PooledStorage::Get(disposeAllHandles[0]) == nullptr);
+    assert(PooledStorage::Get(disposeAllHandles[1]) == nullptr);
+
+    #define HANDLE_METHOD(name, MethodPtr) jni::MakeNativePeerHandleMethod<decltype(MethodPtr), (MethodPtr)>(name)
+
+    jni::RegisterNativePeer<Peer>(env, testClass, "peer",
+        HANDLE_METHOD("true", &Peer::True),
+        HANDLE_METHOD("void", &Peer::Void),
+        HANDLE_METHOD("static", &Peer::Static),
+        jni::MakeNativePeerHandleMethod("static", [] (JNIEnv&, Peer&) {}),
+        METHOD("false", &Peer::False));
+
+    assert(methods[0].signature == std::string("(J)Z"));
+    assert(methods[1].signature == std::string("(JZ)V"));
+    assert(methods[2].signature == std::string("(J)V"));
+    assert(methods[3].signature == std::string("(J)V"));
+    assert(methods[4].signature == std::string("()Z"));
+    assert(reinterpret_cast<jboolean (*)(JNIEnv&, jclass, jlong)>(methods[0].fnPtr)(env, jni::Unwrap(classValue.Ptr()), reinterpret_cast<jlong>(&peerInstance)) == jni::jni_true);
+    reinterpret_cast<void (*)(JNIEnv&, jclass, jlong, jboolean)>(methods[1].fnPtr)(env, jni::Unwrap(classValue.Ptr()), reinterpret_cast<jlong>(&peerInstance), jni::jni_true);
+
+    // A noexcept peer method gets a noexcept wrapper, which raises a Java exception for an invalid handle.
+    static bool threwIllegalState = false;
+    static Testable<jni::jclass> illegalStateClassValue;
+
+    env.fns->FindClass = [] (JNIEnv*, const char* name) -> jclass
+       {
+        assert(name == std::string("java/lang/IllegalStateException"));
+        return jni::Unwrap(illegalStateClassValue.Ptr());
+       };
+
+    env.fns->ThrowNew = [] (JNIEnv*, jclass clazz, const char*) -> jint
+       {
+        assert(clazz == jni::Unwrap(illegalStateClassValue.Ptr()));
+        threwIllegalState = true;
+        return 0;
+       };
+
+    jni::RegisterNativePeer<Peer>(env, testClass, "peer",
+        jni::MakeNativePeerHandleMethod("noexcept", [] (JNIEnv&, Peer&) noexcept { return jni::jni_true; }));
+
+    auto noexceptHandleMethod = reinterpret_cast<jboolean (*)(JNIEnv&, jclass, jlong)>(methods[0].fnPtr);
+    assert(noexceptHandleMethod(env, jni::Unwrap(classValue.Ptr()), reinterpret_cast<jlong>(&peerInstance)) == jni::jni_true);
+    assert(!threwIllegalState);
+    assert(noexceptHandleMethod(env, jni::Unwrap(classValue.Ptr()), 0) == jni::jni_false);
+    assert(threwIllegalState);
+
+    jni::RegisterNatives(env, *testClass, criticalMethod, criticalLambda);
+    assert(methods[0].name == std::string("critical"));
+    assert(methods[0].signature == std::string("(DI)D"));
+
+
+
+    /// Boxing
+
+    static Testable<jni::jclass> integerClassValue;
+    static Testable<jni::jmethodID> integerValueOfMethodID;
+    static Testable<jni::jobject> integerValue;
+    static int integerValueOfCalls = 0;
+
+    static JNIInvokeInterface vmFunctions {};
+    static JavaVM vm { &vmFunctions };
+
+    vmFunctions.GetEnv = [] (JavaVM*, void**, jint) -> jint
+       {
+        return JNI_EDETACHED;
+       };
+
+    env.fns->GetJavaVM = [] (JNIEnv*, JavaVM** result) -> jint
+       {
+        *result = &vm;
+        return JNI_OK;
+       };
+
+    env.fns->FindClass = [] (JNIEnv*, const char* name) -> jclass
+       {
+        assert(name == std::string("java/lang/Integer"));
+        return jni::Unwrap(integerClassValue.Ptr());
+       };
+
+    env.fns->GetStaticMethodID = [] (JNIEnv*, jclass, const char* name, const char* sig) -> jmethodID
+       {
+        assert(name == std::string("valueOf"));
+        assert(sig == std::string("(I)Ljava/lang/Integer;"));
+        return jni::Unwrap(integerValueOfMethodID.Ptr());
+       };
+
+    env.fns->CallStaticObjectMethodV = [] (JNIEnv*, jclass clazz, jmethodID methodID, va_list) -> jobject
+       {
+        assert(clazz == jni::Unwrap(integerClassValue.Ptr()));
+        assert(methodID == jni::Unwrap(integerValueOfMethodID.Ptr()));
+        integerValueOfCalls++;
+        return jni::Unwrap(integerValue.Ptr());
+       };
+
+    assert(jni::Box(env, jni::jint(7)).get() == integerValue.Ptr());
+    assert(integerValueOfCalls == 1);
+    assert(jni::Box(env, jni::jint(7)).get() == integerValue.Ptr());
+    assert(integerValueOfCalls == 1);
+    jni::Box(env, jni::jint(1000));
+    jni::Box(env, jni::jint(1000));
+    assert(integerValueOfCalls == 3);
+
+    static Testable<jni::jfieldID> integerValueFieldID;
+    static Testable<jni::jarray<jni::jobject>> integerArrayValue;
+    static Testable<jni::jobject> integerElementValues[100];
+    static int localFrames = 0;
+
+    env.fns->GetFieldID = [] (JNIEnv*, jclass clazz, const char* name, const char* sig) -> jfieldID
+       {
+        assert(clazz == jni::Unwrap(integerClassValue.Ptr()));
+        assert(name == std::string("value"));
+        assert(sig == std::string("I"));
+        return jni::Unwrap(integerValueFieldID.Ptr());
+       };
+
+    env.fns->GetIntField = [] (JNIEnv*, jobject obj, jfieldID fieldID) -> jint
+       {
+        assert(fieldID == jni::Unwrap(integerValueFieldID.Ptr()));
+        return jint(reinterpret_cast<Testable<jni::jobject>*>(obj) - integerElementValues);
+       };
+
+    env.fns->GetArrayLength = [] (JNIEnv*, jarray array) -> jsize
+       {
+        assert(array == jni::Unwrap(integerArrayValue.Ptr()));
+        return 100;
+       };
+
+    env.fns->GetObjectArrayElement = [] (JNIEnv*, jobjectArray array, jsize index) -> jobject
+       {
+        assert(array == jni::Unwrap(integerArrayValue.Ptr()));
+        return jni::Unwrap(integerElementValues[index].Ptr());
+       };
+
+    env.fns->PushLocalFrame = [] (JNIEnv*, jint capacity) -> jint
+       {
+        assert(capacity <= 64);
+        localFrames++;
+        return JNI_OK;
+       };
+
+    env.fns->PopLocalFrame = [] (JNIEnv*, jobject result) -> jobject
+       {
+        return result;
+       };
+
+    assert(jni::UnboxField(env, jni::Integer(integerElementValues[42].Ptr())) == 42);
+
+    jni::Local<jni::Array<jni::Integer>> integerArray { env, integerArrayValue.Ptr() };
+    std::vector<jni::jint> unboxed = jni::Unbox(env, integerArray);
+    assert(unboxed.size() == 100);
+    assert(unboxed[0] == 0 && unboxed[99] == 99);
+    assert(localFrames == 2);
+
+    // Where the runtime lacks the `value` field, UnboxField clears the resulting NoSuchFieldError
+    // and falls back to the unboxing method.
+    static Testable<jni::jclass> shortClassValue;
+    static Testable<jni::jmethodID> shortValueMethodID;
+    static Testable<jni::jobject> shortValue;
+    static bool clearedNoSuchField = false;
+
+    env.fns->FindClass = [] (JNIEnv*, const char* name) -> jclass
+       {
+        assert(name == std::string("java/lang/Short"));
+        return jni::Unwrap(shortClassValue.Ptr());
+       };
+
+    env.fns->GetFieldID = [] (JNIEnv* e, jclass clazz, const char* name, const char* sig) -> jfieldID
+       {
+        assert(clazz == jni::Unwrap(shortClassValue.Ptr()));
+        assert(name == std::string("value"));
+        assert(sig == std::string("S"));
+        reinterpret_cast<TestEnv*>(e)->exception = true;
+        return nullptr;
+       };
+
+    env.fns->ExceptionDescribe = [] (JNIEnv*) {};
+
+    env.fns->ExceptionClear = [] (JNIEnv* e)
+       {
+        reinterpret_cast<TestEnv*>(e)->exception = false;
+        clearedNoSuchField = true;
+       };
+
+    env.fns->GetMethodID = [] (JNIEnv*, jclass clazz, const char* name, const char* sig) -> jmethodID
+       {
+        assert(clazz == jni::Unwrap(shortClassValue.Ptr()));
+        assert(name == std::string("shortValue"));
+        assert(sig == std::string("()S"));
+        return jni::Unwrap(shortValueMethodID.Ptr());
+       };
+
+    env.fns->CallShortMethodV = [] (JNIEnv*, jobject obj, jmethodID methodID, va_list) -> jshort
+       {
+        assert(obj == jni::Unwrap(shortValue.Ptr()));
+        assert(methodID == jni::Unwrap(shortValueMethodID.Ptr()));
+        return 7;
+       };
+
+    assert(jni::UnboxField(env, jni::Short(shortValue.Ptr())) == 7);
+    assert(clearedNoSuchField);
+    assert(!env.exception);
+
+
+    /// Collections
+
+    static Testable<jni::jclass> collectionClassValue;
+    static Testable<jni::jmethodID> toArrayMethodID;
+    static Testable<jni::jobject> listValue;
+
+    env.fns->FindClass = [] (JNIEnv*, const char* name) -> jclass
+       {
+        assert(name == std::string("java/util/Collection"));
+        return jni::Unwrap(collectionClassValue.Ptr());
+       };
+
+    env.fns->GetMethodID = [] (JNIEnv*, jclass clazz, const char* name, const char* sig) -> jmethodID
+       {
+        assert(clazz == jni::Unwrap(collectionClassValue.Ptr()));
+        assert(name == std::string("toArray"));
+        assert(sig == std::string("()[Ljava/lang/Object;"));
+        return jni::Unwrap(toArrayMethodID.Ptr());
+       };
+
+    env.fns->CallObjectMethodV = [] (JNIEnv*, jobject obj, jmethodID methodID, va_list) -> jobject
+       {
+        assert(obj == jni::Unwrap(listValue.Ptr()));
+        assert(methodID == jni::Unwrap(toArrayMethodID.Ptr()));
+        return jni::Unwrap(integerArrayValue.Ptr());
+       };
+
+    jni::Local<jni::List<jni::Integer>> list { env, listValue.Ptr() };
+    std::vector<jni::jint> listElements = jni::Make<std::vector<jni::jint>>(env, list);
+    assert(listElements.size() == 100);
+    assert(listElements[5] == 5);
+
+    // In the other direction, each class and method is identified by its position in `collectionNames`.
+    static std::vector<std::string> collectionNames;
+    static Testable<jni::jclass> collectionClassValues[8];
+    static Testable<jni::jmethodID> collectionMethodIDs[8];
+    static Testable<jni::jobject> boxedIntegers[4];
+    static Testable<jni::jobject> boxedLongValue;
+    static Testable<jni::jarray<jni::jobject>> listArrayValue;
+    static Testable<jni::jobject> asListValue;
+    static Testable<jni::jobject> arrayListValue;
+    static Testable<jni::jobject> hashMapValue;
+    static Testable<jni::jstring> keyValue;
+    static jobject listArrayElements[3] {};
+    static jobject arrayListArgument = nullptr;
+    static jint hashMapCapacity = 0;
+    static std::vector<std::pair<jobject, jobject>> puts;
+
+    static auto collectionIndex = [] (const std::string& name)
+       {
+        auto it = std::find(collectionNames.begin(), collectionNames.end(), name);
+        if (it == collectionNames.end())
+            it = collectionNames.insert(it, name);
+        return std::size_t(it - collectionNames.begin());
+       };
+
+    static auto collectionName = [] (void* p, void* base, std::size_t size)
+       {
+        return collectionNames[(static_cast<char*>(p) - static_cast<char*>(base)) / size];
+       };
+
+    env.fns->FindClass = [] (JNIEnv*, const char* name) -> jclass
+       {
+        return jni::Unwrap(collectionClassValues[collectionIndex(name)].Ptr());
+       };
+
+    env.fns->GetMethodID = [] (JNIEnv*, jclass clazz, const char* name, const char* sig) -> jmethodID
+       {
+        return jni::Unwrap(collectionMethodIDs[collectionIndex(collectionName(clazz, collectionClassValues, sizeof(collectionClassValues[0])) + "." + name + sig)].Ptr());
+       };
+
+    env.fns->GetStaticMethodID = env.fns->GetMethodID;
+
+    env.fns->NewObjectArray = [] (JNIEnv*, jsize length, jclass clazz, jobject) -> jobjectArray
+       {
+        assert(length == 3);
+        assert(collectionName(clazz, collectionClassValues, sizeof(collectionClassValues[0])) == "java/lang/Object");
+        return jni::Unwrap(listArrayValue.Ptr());
+       };
+
+    env.fns->SetObjectArrayElement = [] (JNIEnv*, jobjectArray array, jsize index, jobject value)
+       {
+        assert(array == jni::Unwrap(listArrayValue.Ptr()));
+        listArrayElements[index] = value;
+       };
+
+    env.fns->NewString = [] (JNIEnv*, const jchar* chars, jsize length) -> jstring
+       {
+        assert(length == 1 && chars[0] == u'a');
+        return jni::Unwrap(keyValue.Ptr());
+       };
+
+    env.fns->CallStaticObjectMethodV = [] (JNIEnv*, jclass, jmethodID methodID, va_list args) -> jobject
+       {
+        if (methodID == jni::Unwrap(integerValueOfMethodID.Ptr()))
+            return jni::Unwrap(boxedIntegers[va_arg(args, jint)].Ptr());
+
+        const std::string method = collectionName(methodID, collectionMethodIDs, sizeof(collectionMethodIDs[0]));
+        if (method == "java/lang/Long.valueOf(J)Ljava/lang/Long;")
+           {
+            assert(va_arg(args, jlong) == 1000);
+            return jni::Unwrap(boxedLongValue.Ptr());
+           }
+
+        assert(method == "java/util/Arrays.asList([Ljava/lang/Object;)Ljava/util/List;");
+        assert(va_arg(args, jobject) == jni::Unwrap(listArrayValue.Ptr()));
+        return jni::Unwrap(asListValue.Ptr());
+       };
+
+    env.fns->NewObjectV = [] (JNIEnv*, jclass, jmethodID methodID, va_list args) -> jobject
+       {
+        const std::string method = collectionName(methodID, collectionMethodIDs, sizeof(collectionMethodIDs[0]));
+        if (method == "java/util/ArrayList.<init>(Ljava/util/Collection;)V")
+           {
+            arrayListArgument = va_arg(args, jobject);
+            return jni::Unwrap(arrayListValue.Ptr());
+           }
+
+        assert(method == "java/util/HashMap.<init>(I)V");
+        hashMapCapacity = va_arg(args, jint);
+        return jni::Unwrap(hashMapValue.Ptr());
+       };
+
+    env.fns->CallObjectMethodV = [] (JNIEnv*, jobject obj, jmethodID methodID, va_list args) -> jobject
+       {
+        assert(obj == jni::Unwrap(hashMapValue.Ptr()));
+        assert(collectionName(methodID, collectionMethodIDs, sizeof(collectionMethodIDs[0])) == "java/util/Map.put(Ljava/lang/Object;Ljava/lang/Object;)Ljava/lang/Object;");
+        jobject key = va_arg(args, jobject);
+        jobject value = va_arg(args, jobject);
+        puts.emplace_back(key, value);
+        return nullptr;
+       };
+
+    auto madeList = jni::Make<jni::List<jni::Integer>>(env, std::vector<jni::jint> { 1, 2, 3 });
+    assert(madeList.get() == arrayListValue.Ptr());
+    assert(arrayListArgument == jni::Unwrap(asListValue.Ptr()));
+    for (jni::jint i = 1; i <= 3; ++i)
+        assert(listArrayElements[i - 1] == jni::Unwrap(boxedIntegers[i].Ptr()));
+
+    auto madeMap = jni::Make<jni::Map<jni::String, jni::Long>>(env, std::unordered_map<std::string, jni::jlong> { { "a", 1000 } });
+    assert(madeMap.get() == hashMapValue.Ptr());
+    assert(hashMapCapacity == 2);
+    assert((puts == std::vector<std::pair<jobject, jobject>> { { jni::Unwrap(keyValue.Ptr()), jni::Unwrap(boxedLongValue.Ptr()) } }));
+
+
+    /// StructMapping
+
+    static Testable<jni::jclass> pointClassValue;
+    static Testable<jni::jobject> pointValue;
+    static Testable<jni::jfieldID> pointXFieldID;
+    static Testable<jni::jfieldID> pointYFieldID;
+    static Testable<jni::jmethodID> pointConstructorID;
+    static jni::jint pointX = 3;
+    static jni::jdouble pointY = 4.5;
+    static int pointExceptionChecks = 0;
+
+    env.fns->FindClass = [] (JNIEnv*, const char* name) -> jclass
+       {
+        assert(name == std::string("mapbox/com/Point"));
+        return jni::Unwrap(pointClassValue.Ptr());
+       };
+
+    env.fns->GetFieldID = [] (JNIEnv*, jclass clazz, const char* name, const char* sig) -> jfieldID
+       {
+        assert(clazz == jni::Unwrap(pointClassValue.Ptr()));
+        if (name == std::string("x"))
+           {
+            assert(sig == std::string("I"));
+            return jni::Unwrap(pointXFieldID.Ptr());
+           }
+        assert(name == std::string("y"));
+        assert(sig == std::string("D"));
+        return jni::Unwrap(pointYFieldID.Ptr());
+       };
+
+    env.fns->GetIntField = [] (JNIEnv*, jobject obj, jfieldID fieldID) -> jint
+       {
+        assert(obj == jni::Unwrap(pointValue.Ptr()));
+        assert(fieldID == jni::Unwrap(pointXFieldID.Ptr()));
+        return pointX;
+       };
+
+    env.fns->GetDoubleField = [] (JNIEnv*, jobject obj, jfieldID fieldID) -> jdouble
+       {
+        assert(obj == jni::Unwrap(pointValue.Ptr()));
+        assert(fieldID == jni::Unwrap(pointYFieldID.Ptr()));
+        return pointY;
+       };
+
+    env.fns->SetIntField = [] (JNIEnv*, jobject obj, jfieldID fieldID, jint value)
+       {
+        assert(obj == jni::Unwrap(pointValue.Ptr()));
+        assert(fieldID == jni::Unwrap(pointXFieldID.Ptr()));
+        pointX = value;
+       };
+
+    env.fns->SetDoubleField = [] (JNIEnv*, jobject obj, jfieldID fieldID, jdouble value)
+       {
+        assert(obj == jni::Unwrap(pointValue.Ptr()));
+        assert(fieldID == jni::Unwrap(pointYFieldID.Ptr()));
+        pointY = value;
+       };
+
+    env.fns->GetMethodID = [] (JNIEnv*, jclass clazz, const char* name, const char* sig) -> jmethodID
+       {
+        assert(clazz == jni::Unwrap(pointClassValue.Ptr()));
+        assert(name == std::string("<init>"));
+        assert(sig == std::string("()V"));
+        return jni::Unwrap(pointConstructorID.Ptr());
+       };
+
+    env.fns->NewObjectV = [] (JNIEnv*, jclass clazz, jmethodID methodID, va_list) -> jobject
+       {
+        assert(clazz == jni::Unwrap(pointClassValue.Ptr()));
+        assert(methodID == jni::Unwrap(pointConstructorID.Ptr()));
+        return jni::Unwrap(pointValue.Ptr());
+       };
+
+    jni::Local<jni::Object<PointTag>> pointObject { env, pointValue.Ptr() };
+    Point point = jni::Make<Point>(env, pointObject);
+    assert(point.x == 3);
+    assert(point.y == 4.5);
+
+    env.fns->ExceptionCheck = [] (JNIEnv*) -> jboolean
+       {
+        pointExceptionChecks++;
+        return JNI_FALSE;
+       };
+
+    point.x = 7;
+    point.y = 8.5;
+    jni::Local<jni::Object<PointTag>> madePoint = jni::Make<jni::Object<PointTag>>(env, point);
+    assert(madePoint.get() == pointValue.Ptr());
+    assert(pointX == 7);
+    assert(pointY == 8.5);
+
+    pointExceptionChecks = 0;
+    jni::SetFields(env, madePoint, point);
+    assert(pointExceptionChecks == 1);
+
+    env.fns->ExceptionCheck = [] (JNIEnv* e) -> jboolean
+       {
+        return reinterpret_cast<TestEnv*>(e)->exception ? JNI_TRUE : JNI_FALSE;
+       };
+
+
+    /// Columnar
+
+    static Testable<jni::jarray<jni::jint>> xColumnValue;
+    static Testable<jni::jarray<jni::jdouble>> yColumnValue;
+    static std::vector<jni::jint> xColumn;
+    static std::vector<jni::jdouble> yColumn;
+
+    env.fns->NewIntArray = [] (JNIEnv*, jsize) -> jintArray
+       {
+        return jni::Unwrap(xColumnValue.Ptr());
+       };
+
+    env.fns->NewDoubleArray = [] (JNIEnv*, jsize) -> jdoubleArray
+       {
+        return jni::Unwrap(yColumnValue.Ptr());
+       };
+
+    env.fns->SetIntArrayRegion = [] (JNIEnv*, jintArray array, jsize start, jsize len, const jint* buf)
+       {
+        assert(array == jni::Unwrap(xColumnValue.Ptr()));
+        xColumn.assign(buf + start, buf + start + len);
+       };
+
+    env.fns->SetDoubleArrayRegion = [] (JNIEnv*, jdoubleArray array, jsize start, jsize len, const jdouble* buf)
+       {
+        assert(array == jni::Unwrap(yColumnValue.Ptr()));
+        yColumn.assign(buf + start, buf + start + len);
+       };
+
+    env.fns->GetIntArrayRegion = [] (JNIEnv*, jintArray, jsize start, jsize len, jint* buf)
+       {
+        std::copy(xColumn.begin() + start, xColumn.begin() + start + len, buf);
+       };
+
+    env.fns->GetDoubleArrayRegion = [] (JNIEnv*, jdoubleArray, jsize start, jsize len, jdouble* buf)
+       {
+        std::copy(yColumn.begin() + start, yColumn.begin() + start + len, buf);
+       };
+
+    env.fns->GetArrayLength = [] (JNIEnv*, jarray array) -> jsize
+       {
+        return array == jni::Unwrap(xColumnValue.Ptr()) ? jsize(xColumn.size()) : jsize(yColumn.size());
+       };
+
+    std::vector<Point> points { { 1, 1.5 }, { 2, 2.5 }, { 3, 3.5 } };
+    auto columns = jni::MakeColumns(env, points, &Point::x, &Point::y);
+    assert(std::get<0>(columns).get() == xColumnValue.Ptr());
+    assert(std::get<1>(columns).get() == yColumnValue.Ptr());
+    assert((xColumn == std::vector<jni::jint> { 1, 2, 3 }));
+    assert((yColumn == std::vector<jni::jdouble> { 1.5, 2.5, 3.5 }));
+
+    std::vector<Point> rows = jni::MakeRows<Point>(env,
+        jni::Column(&Point::x, std::get<0>(columns)),
+        jni::Column(&Point::y, std::get<1>(columns)));
+    assert(rows.size() == 3);
+    assert(rows[2].x == 3);
+    assert(rows[2].y == 3.5);
+
+
+    /// Array chunks
+
+    std::vector<std::size_t> chunkSizes;
+    std::vector<jni::jint> streamed;
+    jni::GetArrayChunks(env, std::get<0>(columns), [&] (jni::Span<const jni::jint> chunk)
+       {
+        chunkSizes.push_back(chunk.size());
+        streamed.insert(streamed.end(), chunk.begin(), chunk.end());
+       }, 2);
+    assert((chunkSizes == std::vector<std::size_t> { 2, 1 }));
+    assert((streamed == std::vector<jni::jint> { 1, 2, 3 }));
+
+    env.fns->SetIntArrayRegion = [] (JNIEnv*, jintArray array, jsize start, jsize len, const jint* buf)
+       {
+        assert(array == jni::Unwrap(xColumnValue.Ptr()));
+        assert(len <= 2);
+        std::copy(buf, buf + len, xColumn.begin() + start);
+       };
+
+    jni::jint next = 10;
+    std::size_t filled = jni::SetArrayChunks(env, std::get<0>(columns), [&] (jni::Span<jni::jint> chunk)
+       {
+        for (jni::jint& e : chunk) e = next++;
+        return chunk.size();
+       }, 2);
+    assert(filled == 3);
+    assert((xColumn == std::vector<jni::jint> { 10, 11, 12 }));
+
+
+    /// I/O
+
+    static Testable<jni::jarray<jni::jbyte>> ioArrayValue;
+    static std::string ioBytes = "hello, world";
+    static int ioCriticals = 0;
+
+    env.fns->GetArrayLength = [] (JNIEnv*, jarray array) -> jsize
+       {
+        assert(array == jni::Unwrap(ioArrayValue.Ptr()));
+        return jsize(ioBytes.size());
+       };
+
+    env.fns->GetPrimitiveArrayCritical = [] (JNIEnv*, jarray array, jboolean* isCopy) -> void*
+       {
+        assert(array == jni::Unwrap(ioArrayValue.Ptr()));
+        ioCriticals++;
+        *isCopy = JNI_FALSE;
+        return &ioBytes[0];
+       };
+
+    env.fns->ReleasePrimitiveArrayCritical = [] (JNIEnv*, jarray array, void* carray, jint mode)
+       {
+        assert(array == jni::Unwrap(ioArrayValue.Ptr()));
+        assert(carray == &ioBytes[0]);
+        assert(mode == JNI_ABORT);
+        ioCriticals--;
+       };
+
+    env.fns->GetByteArrayRegion = [] (JNIEnv*, jbyteArray, jsize start, jsize len, jbyte* buf)
+       {
+        assert(ioCriticals == 0);
+        ioBytes.copy(reinterpret_cast<char*>(buf), jni::Wrap<std::size_t>(len), jni::Wrap<std::size_t>(start));
+       };
+
+    env.fns->SetByteArrayRegion = [] (JNIEnv*, jbyteArray, jsize start, jsize len, const jbyte* buf)
+       {
+        ioBytes.replace(jni::Wrap<std::size_t>(start), jni::Wrap<std::size_t>(len), reinterpret_cast<const char*>(buf), jni::Wrap<std::size_t>(len));
+       };
+
+    int fds[2];
+    assert(pipe(fds) == 0);
+
+    jni::Local<jni::Array<jni::jbyte>> ioArray { env, ioArrayValue.Ptr() };
+    jni::WriteArray(env, fds[1], ioArray, 0, 5);
+    jni::WriteArray(env, fds[1], ioArray, 5, 7, 0);
+    jni::WriteArrays(env, fds[1], { { ioArray, 7, 5 }, { ioArray, 0, 5 } });
+    assert(ioCriticals == 0);
+
+    char written[22];
+    assert(read(fds[0], written, sizeof(written)) == 22);
+    assert(std::string(written, sizeof(written)) == "hello, worldworldhello");
+
+    assert(write(fds[1], "HELLO", 5) == 5);
+    close(fds[1]);
+    assert(jni::ReadIntoArray(env, fds[0], ioArray, 7, 5, 2) == 5);
+    assert(ioBytes == "hello, HELLO");
+    close(fds[0]);
+
+    assert(Throws<std::system_error>([&] { jni::WriteArray(env, fds[1], ioArray, 0, 5); }));
+
+
+    /// Nested arrays
+
+    static Testable<jni::jarray<jni::jobject>> rasterValue;
+    static Testable<jni::jarray<jni::jfloat>> rasterRowValues[3];
+    static std::vector<jni::jfloat> rasterRows[3] { { 1, 2 }, { }, { 3, 4, 5 } };
+    static int rasterFrames = 0;
+    static int rasterNewRows = 0;
+
+    env.fns->FindClass = [] (JNIEnv*, const char* name) -> jclass
+       {
+        assert(name == std::string("[F"));
+        return nullptr;
+       };
+
+    env.fns->GetArrayLength = [] (JNIEnv*, jarray array) -> jsize
+       {
+        if (array == jni::Unwrap(rasterValue.Ptr()))
+            return 3;
+        return jsize(rasterRows[reinterpret_cast<Testable<jni::jarray<jni::jfloat>>*>(array) - rasterRowValues].size());
+       };
+
+    env.fns->GetObjectArrayElement = [] (JNIEnv*, jobjectArray array, jsize index) -> jobject
+       {
+        assert(array == jni::Unwrap(rasterValue.Ptr()));
+        return jni::Unwrap(rasterRowValues[index].Ptr());
+       };
+
+    env.fns->GetFloatArrayRegion = [] (JNIEnv*, jfloatArray array, jsize start, jsize len, jfloat* buf)
+       {
+        const auto& row = rasterRows[reinterpret_cast<Testable<jni::jarray<jni::jfloat>>*>(array) - rasterRowValues];
+        std::copy(row.begin() + start, row.begin() + start + len, buf);
+       };
+
+    env.fns->NewObjectArray = [] (JNIEnv*, jsize length, jclass, jobject) -> jobjectArray
+       {
+        assert(length == 3);
+        return jni::Unwrap(rasterValue.Ptr());
+       };
+
+    env.fns->NewFloatArray = [] (JNIEnv*, jsize length) -> jfloatArray
+       {
+        rasterRows[rasterNewRows].resize(length);
+        return jni::Unwrap(rasterRowValues[rasterNewRows++].Ptr());
+       };
+
+    env.fns->SetFloatArrayRegion = [] (JNIEnv*, jfloatArray array, jsize start, jsize len, const jfloat* buf)
+       {
+        auto& row = rasterRows[reinterpret_cast<Testable<jni::jarray<jni::jfloat>>*>(array) - rasterRowValues];
+        std::copy(buf, buf + len, row.begin() + start);
+       };
+
+    env.fns->SetObjectArrayElement = [] (JNIEnv*, jobjectArray array, jsize index, jobject value)
+       {
+        assert(array == jni::Unwrap(rasterValue.Ptr()));
+        assert(value == jni::Unwrap(rasterRowValues[index].Ptr()));
+       };
+
+    env.fns->PushLocalFrame = [] (JNIEnv*, jint) -> jint
+       {
+        rasterFrames++;
+        return JNI_OK;
+       };
+
+    jni::Local<jni::Array<jni::Array<jni::jfloat>>> raster { env, rasterValue.Ptr() };
+    assert(raster.Get(env, 2).get() == rasterRowValues[2].Ptr());
+
+    auto nested = jni::Make<std::vector<std::vector<jni::jfloat>>>(env, raster);
+    assert(nested.size() == 3);
+    assert((nested[0] == std::vector<jni::jfloat> { 1, 2 }));
+    assert(nested[1].empty());
+    assert((nested[2] == std::vector<jni::jfloat> { 3, 4, 5 }));
+    assert(rasterFrames == 1);
+
+    auto matrix = jni::Make<jni::Matrix<jni::jfloat>>(env, raster);
+    assert(matrix.Rows() == 3);
+    assert((matrix.values == std::vector<jni::jfloat> { 1, 2, 3, 4, 5 }));
+    assert((matrix.offsets == std::vector<std::size_t> { 0, 2, 2, 5 }));
+    assert(matrix.Row(2)[1] == 4);
+
+    for (auto& row : matrix.values) row *= 10;
+    auto fromMatrix = jni::Make<jni::Array<jni::Array<jni::jfloat>>>(env, matrix);
+    assert(fromMatrix.get() == rasterValue.Ptr());
+    assert(rasterNewRows == 3);
+    assert((rasterRows[2] == std::vector<jni::jfloat> { 30, 40, 50 }));
+
+    rasterNewRows = 0;
+    jni::Make<jni::Array<jni::Array<jni::jfloat>>>(env, nested);
+    assert((rasterRows[0] == std::vector<jni::jfloat> { 1, 2 }));
+    assert(rasterFrames == 4);
+
+
+    /// Critical sections
+
+    static Testable<jni::jarray<jni::jdouble>> coordinateValues[2];
+    static jni::jdouble coordinates[2][3] { { 1, 2, 3 }, { 4, 5, 6 } };
+    static Testable<jni::jstring> labelValue;
+    static const char16_t label[] = u"xy";
+    static std::vector<void*> pinnedOrder;
+    static std::vector<void*> releasedOrder;
+    static bool failPinning = false;
+
+    env.fns->GetArrayLength = [] (JNIEnv*, jarray) -> jsize
+       {
+        return 3;
+       };
+
+    env.fns->GetStringLength = [] (JNIEnv*, jstring string) -> jsize
+       {
+        assert(string == jni::Unwrap(labelValue.Ptr()));
+        return 2;
+       };
+
+    env.fns->GetPrimitiveArrayCritical = [] (JNIEnv*, jarray array, jboolean*) -> void*
+       {
+        assert(jni::CriticalSectionDepth() == 0);
+        const auto index = reinterpret_cast<Testable<jni::jarray<jni::jdouble>>*>(array) - coordinateValues;
+        pinnedOrder.push_back(coordinates[index]);
+        return coordinates[index];
+       };
+
+    env.fns->ReleasePrimitiveArrayCritical = [] (JNIEnv*, jarray, void* carray, jint mode)
+       {
+        assert(mode == 0);
+        releasedOrder.push_back(carray);
+       };
+
+    env.fns->GetStringCritical = [] (JNIEnv*, jstring, jboolean*) -> const jchar*
+       {
+        if (failPinning)
+            return nullptr;
+        pinnedOrder.push_back(const_cast<char16_t*>(label));
+        return reinterpret_cast<const jchar*>(label);
+       };
+
+    env.fns->ReleaseStringCritical = [] (JNIEnv*, jstring, const jchar* chars)
+       {
+        releasedOrder.push_back(const_cast<jchar*>(chars));
+       };
+
+    jni::Local<jni::Array<jni::jdouble>> xs { env, coordinateValues[0].Ptr() };
+    jni::Local<jni::Array<jni::jdouble>> ys { env, coordinateValues[1].Ptr() };
+    jni::Local<jni::String> name { env, labelValue.Ptr() };
+
+       {
+        auto section = jni::MakeCriticalSection(env, xs, ys, name);
+        assert(jni::CriticalSectionDepth() == 1);
+
+        jni::Span<jni::jdouble> x = section.Get<0>();
+        jni::Span<jni::jdouble> y = section.Get<1>();
+        assert(x.size() == 3 && y.size() == 3);
+        for (std::size_t i = 0; i < x.size(); ++i) x[i] += y[i];
+
+        jni::Span<const char16_t> chars = section.Get<2>();
+        assert(chars.size() == 2 && chars[1] == u'y');
+       }
+
+    assert(jni::CriticalSectionDepth() == 0);
+    assert(coordinates[0][2] == 9);
+    assert((releasedOrder == std::vector<void*> { pinnedOrder[2], pinnedOrder[1], pinnedOrder[0] }));
+
+    failPinning = true;
+    pinnedOrder.clear();
+    releasedOrder.clear();
+    assert(Throws<std::bad_alloc>([&] { jni::MakeCriticalSection(env, xs, ys, name); }));
+    assert((releasedOrder == std::vector<void*> { pinnedOrder[1], pinnedOrder[0] }));
+    assert(jni::CriticalSectionDepth() == 0);
+
+    /// Global reference pool
+
+    static Testable<jni::jarray<jni::jobject>> segmentValues[2];
+    static jobject segmentElements[2][2] {};
+    static Testable<jni::jobject> pooledValues[3];
+    static int segmentsCreated = 0;
+
+    env.fns->FindClass = [] (JNIEnv*, const char*) -> jclass
+       {
+        return jni::Unwrap(classValue.Ptr());
+       };
+
+    env.fns->NewObjectArray = [] (JNIEnv*, jsize length, jclass, jobject) -> jobjectArray
+       {
+        assert(length == 2);
+        return jni::Unwrap(segmentValues[segmentsCreated++].Ptr());
+       };
+
+    env.fns->SetObjectArrayElement = [] (JNIEnv*, jobjectArray array, jsize index, jobject value)
+       {
+        segmentElements[reinterpret_cast<Testable<jni::jarray<jni::jobject>>*>(array) - segmentValues][index] = value;
+       };
+
+    env.fns->GetObjectArrayElement = [] (JNIEnv*, jobjectArray array, jsize index) -> jobject
+       {
+        return segmentElements[reinterpret_cast<Testable<jni::jarray<jni::jobject>>*>(array) - segmentValues][index];
+       };
+
+       {
+        jni::GlobalRefPool<jni::Object<Test>> pool(2, 2);
+        assert(pool.Capacity() == 0);
+
+        std::vector<jni::GlobalRefPool<jni::Object<Test>>::Handle> handles;
+        for (auto& value : pooledValues)
+            handles.push_back(pool.Add(env, jni::Local<jni::Object<Test>>(env, value.Ptr())));
+
+        assert(segmentsCreated == 2);
+        assert(pool.Size() == 3 && pool.Capacity() == 4);
+        assert(handles[2].Get(env).get() == pooledValues[2].Ptr());
+        assert(segmentElements[1][0] == jni::Unwrap(pooledValues[2].Ptr()));
+
+        // Removing an object clears its slot and makes it available for reuse.
+        handles[1].reset();
+        assert(!handles[1]);
+        assert(segmentElements[0][1] == nullptr);
+        assert(pool.Size() == 2);
+
+        handles[1] = pool.Add(env, jni::Local<jni::Object<Test>>(env, pooledValues[0].Ptr()));
+        assert(segmentElements[0][1] == jni::Unwrap(pooledValues[0].Ptr()));
+        assert(segmentsCreated == 2);
+
+        handles.push_back(pool.Add(env, jni::Local<jni::Object<Test>>(env, pooledValues[1].Ptr())));
+        assert(Throws<std::bad_alloc>([&] { pool.Add(env, jni::Local<jni::Object<Test>>(env, pooledValues[1].Ptr())); }));
+        assert(pool.Size() == 4);
+
+        vmFunctions.GetEnv = [] (JavaVM*, void** result, jint) -> jint
+           {
+            *result = &env;
+            return JNI_OK;
+           };
+       }
+
+    vmFunctions.GetEnv = [] (JavaVM*, void**, jint) -> jint
+       {
+        return JNI_EDETACHED;
+       };
+
+    // Slots freed on one thread are reused for objects added on another, rather than the adding
+    // thread allocating further segments.
+    env.fns->NewObjectArray = [] (JNIEnv*, jsize, jclass, jobject) -> jobjectArray
+       {
+        return jni::Unwrap(segmentValues[segmentsCreated++ % 2].Ptr());
+       };
+
+       {
+        jni::GlobalRefPool<jni::Object<Test>> pool(2, 64);
+        for (int i = 0; i < 64; ++i)
+           {
+            auto handle = pool.Add(env, jni::Local<jni::Object<Test>>(env, pooledValues[0].Ptr()));
+            std::thread([&] { handle.reset(env); }).join();
+           }
+
+        assert(pool.Size() == 0);
+        assert(pool.Capacity() == 2);
+
+        vmFunctions.GetEnv = [] (JavaVM*, void** result, jint) -> jint
+           {
+            *result = &env;
+            return JNI_OK;
+           };
+       }
+
+    vmFunctions.GetEnv = [] (JavaVM*, void**, jint) -> jint
+       {
+        return JNI_EDETACHED;
+       };
+
+    /// Handle table
+
+    static Testable<jni::jobject> tabledValues[4];
+    static jobject collected = nullptr;
+    static std::vector<jobject> deletedGlobals;
+    static std::vector<jobject> deletedWeaks;
+
+    env.fns->NewLocalRef = [] (JNIEnv*, jobject obj) -> jobject
+       {
+        return obj == collected ? nullptr : obj;
+       };
+
+    env.fns->IsSameObject = [] (JNIEnv*, jobject a, jobject b) -> jboolean
+       {
+        return a == b || (b == nullptr && a == collected);
+       };
+
+    env.fns->DeleteGlobalRef = [] (JNIEnv*, jobject obj)
+       {
+        deletedGlobals.push_back(obj);
+       };
+
+    env.fns->DeleteWeakGlobalRef = [] (JNIEnv*, jobject obj)
+       {
+        deletedWeaks.push_back(obj);
+       };
+
+       {
+        using Table = jni::HandleTable<jni::Object<Test>>;
+        Table table(env);
+
+        auto object = [] (std::size_t i) { return jni::Local<jni::Object<Test>>(env, tabledValues[i].Ptr()); };
+        std::vector<Table::Handle> handles;
+        handles.push_back(table.Add(env, object(0)));
+        handles.push_back(table.Add(env, object(1)));
+        handles.push_back(table.AddWeak(env, object(2)));
+        handles.push_back(table.AddWeak(env, object(3)));
+
+        assert(table.Size() == 4);
+        assert(!table.Contains(0));
+        assert(table.Get(env, handles[0]).get() == tabledValues[0].Ptr());
+        assert(table.Get(env, handles[2]).get() == tabledValues[2].Ptr());
+
+        // A collected weak entry yields an empty result until swept.
+        collected = jni::Unwrap(tabledValues[2].Ptr());
+        assert(!table.Get(env, handles[2]));
+        assert(table.Contains(handles[2]));
+        assert(table.SweepWeak(env) == 1);
+        assert(!table.Contains(handles[2]));
+        assert(table.Contains(handles[3]));
+        assert((deletedWeaks == std::vector<jobject> { collected }));
+        assert(table.Size() == 3);
+        collected = nullptr;
+
+        // A reused slot does not answer to the stale handle.
+        assert(table.Remove(env, handles[0]));
+        assert(!table.Remove(env, handles[0]));
+        const Table::Handle reused = table.Add(env, object(2));
+        assert(reused != handles[0]);
+        assert(!table.Get(env, handles[0]));
+        assert(table.Get(env, reused).get() == tabledValues[2].Ptr());
+
+        assert(table.Remove(env, handles.begin(), handles.end()) == 2);
+        assert(deletedGlobals.size() == 2 && deletedWeaks.size() == 2);
+        assert(table.Size() == 1);
+
+        vmFunctions.GetEnv = [] (JavaVM*, void** result, jint) -> jint
+           {
+            *result = &env;
+            return JNI_OK;
+           };
+       }
+
+    assert((deletedGlobals == std::vector<jobject> { jni::Unwrap(tabledValues[0].Ptr()), jni::Unwrap(tabledValues[1].Ptr()), jni::Unwrap(tabledValues[2].Ptr()) }));
+
+    vmFunctions.GetEnv = [] (JavaVM*, void**, jint) -> jint
+       {
+        return JNI_EDETACHED;
+       };
+
+    /// Deferred deletions
+
+    deletedGlobals.clear();
+    auto deferrable = [] { return jni::NewGlobal<jni::EnvDeferringDeleter>(env, jni::Local<jni::Object<Test>>(env, tabledValues[0].Ptr())); };
+
+    // On a detached thread, deletions are queued rather than attaching.
+       {
+        std::vector<decltype(deferrable())> globals;
+        for (int i = 0; i < 3; ++i)
+            globals.push_back(deferrable());
+       }
+
+    assert(jni::DeferredDeletions::Pending() == 3);
+    assert(deletedGlobals.empty());
+
+    // The next deletion on an attached thread deletes the queued references too.
+    vmFunctions.GetEnv = [] (JavaVM*, void** result, jint) -> jint
+       {
+        *result = &env;
+        return JNI_OK;
+       };
+
+    deferrable();
+    assert(jni::DeferredDeletions::Pending() == 0);
+    assert(deletedGlobals.size() == 4);
+
+    vmFunctions.GetEnv = [] (JavaVM*, void**, jint) -> jint
+       {
+        return JNI_EDETACHED;
+       };
+
+    deferrable();
+    assert(jni::DeferredDeletions::Pending() == 1);
+    assert(jni::DeferredDeletions::Flush(env) == 1);
+    assert(deletedGlobals.size() == 5);
+
+    // Deferrals from several detached threads at once are all queued.
+       {
+        std::vector<std::vector<decltype(deferrable())>> perThread(4);
+        for (auto& globals : perThread)
+            for (int i = 0; i < 8; ++i)
+                globals.push_back(deferrable());
+
+        std::vector<std::thread> threads;
+        for (auto& globals : perThread)
+            threads.emplace_back([&globals] { globals.clear(); });
+        for (auto& thread : threads)
+            thread.join();
+       }
+
+    assert(jni::DeferredDeletions::Pending() == 32);
+    assert(deletedGlobals.size() == 5);
+
+    // Flushing with a JavaVM gets an attached JNIEnv, and deletes the whole batch with it.
+    vmFunctions.GetEnv = [] (JavaVM*, void** result, jint) -> jint
+       {
+        *result = &env;
+        return JNI_OK;
+       };
+
+    assert(jni::DeferredDeletions::Flush(vm) == 32);
+    assert(jni::DeferredDeletions::Pending() == 0);
+    assert(deletedGlobals.size() == 37);
+    assert(jni::DeferredDeletions::Flush(vm) == 0);
+
+    vmFunctions.GetEnv = [] (JavaVM*, void**, jint) -> jint
+       {
+        return JNI_EDETACHED;
+       };
+
+    // After shutdown, deferred deletions are ignored.
+    jni::DeferredDeletions::Shutdown(env);
+    deferrable();
+    assert(jni::DeferredDeletions::Pending() == 0);
+    assert(deletedGlobals.size() == 37);
+
+    /// Weak cache
+
+    vmFunctions.GetEnv = [] (JavaVM*, void** result, jint) -> jint
+       {
+        *result = &env;
+        return JNI_OK;
+       };
+
+       {
+        jni::WeakCache<int, jni::Object<Test>> cache(1);
+        auto object = [] (std::size_t i) { return jni::Local<jni::Object<Test>>(env, tabledValues[i].Ptr()); };
+
+        cache.Put(env, 0, object(0));
+        cache.Put(env, 1, object(1));
+        cache.Put(env, 2, object(2));
+        assert(cache.Size() == 3);
+        assert(cache.Get(env, 1).get() == tabledValues[1].Ptr());
+        assert(!cache.Get(env, 3));
+
+        // A collected entry is removed when looked up.
+        collected = jni::Unwrap(tabledValues[1].Ptr());
+        assert(!cache.Get(env, 1));
+        assert(cache.Size() == 2);
+
+        // Or, incrementally, by later insertions.
+        collected = jni::Unwrap(tabledValues[0].Ptr());
+        cache.Put(env, 3, object(3));
+        cache.Put(env, 4, object(3));
+        assert(cache.Size() == 3);
+        assert(!cache.Get(env, 0) && cache.Get(env, 2) && cache.Get(env, 3) && cache.Get(env, 4));
+
+        collected = jni::Unwrap(tabledValues[3].Ptr());
+        assert(cache.Sweep(env) == 2);
+        assert(cache.Size() == 1);
+        assert(cache.Erase(2));
+        assert(!cache.Erase(2));
+        assert(cache.Size() == 0);
+        collected = nullptr;
+       }
+
+    vmFunctions.GetEnv = [] (JavaVM*, void**, jint) -> jint
+       {
+        return JNI_EDETACHED;
+       };
+
+    /// Weak reference
+
+    static Testable<jni::jmethodID> weakReferenceGetMethodID;
+    static int weakReferenceGetCalls = 0;
+    static int weakFrames = 0;
+    static int deletedLocals = 0;
+
+    // Each mock WeakReference is represented by its referent.
+    env.fns->GetMethodID = [] (JNIEnv*, jclass, const char* name, const char*) -> jmethodID
+       {
+        return jni::Unwrap(name == std::string("get") ? weakReferenceGetMethodID.Ptr() : objectConstructorMethodID.Ptr());
+       };
+
+    env.fns->NewObjectV = [] (JNIEnv*, jclass, jmethodID, va_list args) -> jobject
+       {
+        return va_arg(args, jobject);
+       };
+
+    env.fns->CallObjectMethodV = [] (JNIEnv*, jobject obj, jmethodID methodID, va_list) -> jobject
+       {
+        assert(methodID == jni::Unwrap(weakReferenceGetMethodID.Ptr()));
+        weakReferenceGetCalls++;
+        return obj == collected ? nullptr : obj;
+       };
+
+    env.fns->PushLocalFrame = [] (JNIEnv*, jint) -> jint
+       {
+        weakFrames++;
+        return JNI_OK;
+       };
+
+    env.fns->DeleteLocalRef = [] (JNIEnv*, jobject)
+       {
+        deletedLocals++;
+       };
+
+       {
+        std::vector<jni::WeakReference<jni::Object<Test>>> weakReferences;
+        for (std::size_t i = 0; i < 4; ++i)
+            weakReferences.emplace_back(env, jni::Local<jni::Object<Test>>(env, tabledValues[i].Ptr()));
+
+        const jni::WeakReference<jni::Object<Test>>& weakReference = weakReferences[1];
+        assert(!weakReference.IsCleared(env));
+        assert(weakReference.TryGet(env).get() == tabledValues[1].Ptr());
+        assert(weakReferenceGetCalls == 1);
+
+        // Once cleared, TryGet doesn't call get().
+        collected = jni::Unwrap(tabledValues[1].Ptr());
+        assert(weakReference.IsCleared(env));
+        assert(!weakReference.TryGet(env));
+        assert(weakReferenceGetCalls == 1);
+        assert(!weakReference.get(env));
+        assert(weakReferenceGetCalls == 2);
+
+        deletedLocals = 0;
+        std::vector<jni::jobject*> visited;
+        jni::GetAll(env, weakReferences, [&] (const jni::Object<Test>& referent) { visited.push_back(referent.get()); });
+        assert((visited == std::vector<jni::jobject*> { tabledValues[0].Ptr(), tabledValues[2].Ptr(), tabledValues[3].Ptr() }));
+        assert(weakFrames == 1);
+        assert(deletedLocals == 0);
+        collected = nullptr;
+       }
+
     return 0;
    }
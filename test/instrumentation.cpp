@@ -0,0 +1,113 @@
+#include "test.hpp"
+
+#include <jni/instrumentation.hpp>
+
+namespace jni
+   {
+    template <> struct InstrumentationPolicy<> { using Type = CallStatistics; };
+   }
+
+#include <jni/jni.hpp>
+
+#include <cassert>
+#include <sstream>
+#include <thread>
+
+static const jni::FunctionStatistics* Find(const std::vector<jni::FunctionStatistics>& snapshot, jni::JNIFunction function)
+   {
+    for (const auto& s : snapshot)
+        if (s.function == function)
+            return &s;
+    return nullptr;
+   }
+
+int main()
+   {
+    static_assert(std::is_same<jni::Instrumentation, jni::CallStatistics>::value, "");
+
+    static TestEnv env;
+    static Testable<jni::jclass> classValue;
+    static Testable<jni::jobject> objectValue;
+    static Testable<jni::jfieldID> fieldValue;
+
+    env.fns->FindClass = [] (JNIEnv*, const char* name) -> jclass
+       {
+        if (name == std::string("Missing"))
+            env.exception = true;
+        return jni::Unwrap(classValue.Ptr());
+       };
+
+    env.fns->ExceptionDescribe = [] (JNIEnv*) {};
+
+    env.fns->GetIntField = [] (JNIEnv*, jobject, jfieldID) -> jint
+       {
+        return 42;
+       };
+
+    assert(jni::CallStatistics::Snapshot().empty());
+
+    jni::FindClass(env, "Present");
+    assert(Throws<jni::PendingJavaException>([] { jni::FindClass(env, "Missing"); }));
+    env.exception = false;
+
+    std::thread([] {
+        for (int i = 0; i < 10; ++i)
+            assert(jni::GetField<jni::jint>(env, objectValue.Ptr(), fieldValue.Ref()) == 42);
+    }).join();
+
+    jni::GetField<jni::jint>(env, objectValue.Ptr(), fieldValue.Ref());
+
+    auto snapshot = jni::CallStatistics::Snapshot();
+    assert(snapshot.size() == 2);
+
+    const jni::FunctionStatistics* findClass = Find(snapshot, jni::JNIFunction::FindClass);
+    assert(findClass);
+    assert(findClass->calls == 2);
+    assert(findClass->javaExceptions == 1);
+
+    const jni::FunctionStatistics* getField = Find(snapshot, jni::JNIFunction::GetField);
+    assert(getField);
+    assert(getField->calls == 11);
+    assert(getField->javaExceptions == 0);
+
+    std::uint64_t histogramTotal = 0;
+    for (std::uint64_t count : getField->histogram)
+        histogramTotal += count;
+    assert(histogramTotal == 11);
+
+    std::ostringstream json;
+    jni::WriteJSON(json, snapshot);
+    assert(json.str().find("{\"function\":\"Get<Type>Field\",\"calls\":11,\"javaExceptions\":0") != std::string::npos);
+
+    // Deleters are instrumented too.
+    static bool deletedLocal = false;
+    env.fns->DeleteLocalRef = [] (JNIEnv*, jobject) { deletedLocal = true; };
+
+       {
+        jni::Local<jni::Object<>> local(env, objectValue.Ptr());
+       }
+    assert(deletedLocal);
+
+    snapshot = jni::CallStatistics::Snapshot();
+    const jni::FunctionStatistics* deleteLocalRef = Find(snapshot, jni::JNIFunction::DeleteLocalRef);
+    assert(deleteLocalRef);
+    assert(deleteLocalRef->calls == 1);
+
+    // Including those that get the JNIEnv from the JavaVM.
+    static JNIInvokeInterface vmFunctions {};
+    static JavaVM vm { &vmFunctions };
+
+    vmFunctions.GetEnv = [] (JavaVM*, void** result, jint) -> jint { *result = &env; return JNI_OK; };
+    env.fns->GetJavaVM = [] (JNIEnv*, JavaVM** result) -> jint { *result = &vm; return JNI_OK; };
+    env.fns->NewGlobalRef = [] (JNIEnv*, jobject obj) -> jobject { return obj; };
+    env.fns->DeleteGlobalRef = [] (JNIEnv*, jobject) {};
+
+    jni::NewGlobal<jni::EnvGettingDeleter>(env, jni::Object<>(objectValue.Ptr()));
+
+    snapshot = jni::CallStatistics::Snapshot();
+    const jni::FunctionStatistics* deleteGlobalRef = Find(snapshot, jni::JNIFunction::DeleteGlobalRef);
+    assert(deleteGlobalRef);
+    assert(deleteGlobalRef->calls == 1);
+
+    return 0;
+   }
@@ -223,6 +223,24 @@ static void TestArrayRegion()
 
     boolean = jni::jni_false;
     jni::SetArrayRegion<jni::jboolean>(env, arrayValue.Ref(), 0, 1, &boolean);
+
+    static_assert(jni::IsArraylike<jni::Span<jni::jboolean>>::value, "");
+    static_assert(jni::IsArraylike<jni::jboolean[4]>::value, "");
+    static_assert(!jni::IsArraylike<jni::jboolean*>::value, "");
+    static_assert(std::is_same<jni::ArraylikeElement<std::vector<jni::jboolean>>, jni::jboolean>::value, "");
+
+    std::vector<jni::jboolean> buffer(4, jni::jni_false);
+    jni::GetArrayRegion(env, arrayValue.Ref(), 0, jni::MakeSpan(buffer, 2, 1));
+    assert(buffer[1] == jni::jni_false);
+    assert(buffer[2] == jni::jni_true);
+
+    jni::jboolean single[1] = { jni::jni_false };
+    jni::GetArrayRegion(env, arrayValue.Ref(), 0, single);
+    assert(single[0] == jni::jni_true);
+
+    buffer[2] = jni::jni_false;
+    jni::SetArrayRegion(env, arrayValue.Ref(), 0, jni::MakeSpan(&buffer[2], &buffer[3]));
+    assert(Throws<std::out_of_range>([&] { jni::MakeSpan(buffer, 3, 2); }));
    }
 
 namespace
@@ -237,6 +255,8 @@ namespace
        };
    }
 
+static void NoexceptMethod(jni::JNIEnv*, jni::jobject*) noexcept {}
+
 static void TestMakeNativeMethod()
    {
    // None of these should compile:
@@ -256,6 +276,15 @@ static void TestMakeNativeMethod()
     jni::MakeNativeMethod("name", "sig", [] (jni::JNIEnv*, jni::jclass*) {});
     jni::MakeNativeMethod("name", "sig", [] (jni::JNIEnv*, jni::jobject*) mutable {});
     jni::MakeNativeMethod("name", "sig", [] (jni::JNIEnv*, jni::jclass*) mutable {});
+
+    // noexcept implementations are registered without an exception-translating wrapper.
+    auto noexceptMethod = [] (jni::JNIEnv*, jni::jobject*) noexcept {};
+    using NoexceptMethodType = void (jni::JNIEnv*, jni::jobject*);
+    assert(jni::MakeNativeMethod("name", "sig", noexceptMethod).fnPtr == static_cast<NoexceptMethodType*>(noexceptMethod));
+    assert(jni::MakeNativeMethod("name", "sig", [] (jni::JNIEnv*, jni::jobject*) {}).fnPtr != nullptr);
+
+    // Before C++17, a noexcept function pointer must be registered with MakeNoexceptNativeMethod.
+    assert((jni::MakeNoexceptNativeMethod< decltype(&NoexceptMethod), &NoexceptMethod >("name", "sig").fnPtr == &NoexceptMethod));
    }
 
 int main()
@@ -0,0 +1,178 @@
+#include "test.hpp"
+
+#include <jni/reference_tracking.hpp>
+
+namespace jni
+   {
+    template <> struct ReferenceTrackingPolicy<> { using Type = ReferenceStatistics; };
+   }
+
+#include <jni/jni.hpp>
+
+#include <cassert>
+#include <sstream>
+#include <thread>
+
+static Testable<jni::jobject> objects[16];
+static std::size_t nextObject = 0;
+
+static jobject NewObject(JNIEnv*, jobject)
+   {
+    return jni::Unwrap(objects[nextObject++ % 16].Ptr());
+   }
+
+static std::uint64_t leaked = 0;
+
+static void OnLeak(const jni::ReferenceSiteStatistics& site, std::uint64_t count)
+   {
+    assert(site.kind == jni::ReferenceKind::Local);
+    leaked += count;
+   }
+
+static const jni::ReferenceSiteStatistics* Find(const jni::ReferenceReport& report, jni::JNIFunction function, const std::string& site)
+   {
+    for (const auto& s : report.sites)
+        if (s.function == function && s.site == site)
+            return &s;
+    return nullptr;
+   }
+
+static const jni::ReferenceCounts& Counts(const jni::ReferenceReport& report, jni::ReferenceKind kind)
+   {
+    return report.kinds[static_cast<std::size_t>(kind)];
+   }
+
+int main()
+   {
+    static_assert(std::is_same<jni::ReferenceTracking, jni::ReferenceStatistics>::value, "");
+
+    static TestEnv env;
+    static Testable<jni::jobject> objectValue;
+
+    env.fns->NewLocalRef = NewObject;
+    env.fns->NewGlobalRef = NewObject;
+    env.fns->DeleteLocalRef = [] (JNIEnv*, jobject) {};
+    env.fns->DeleteGlobalRef = [] (JNIEnv*, jobject) {};
+    env.fns->PushLocalFrame = [] (JNIEnv*, jint) -> jint { return JNI_OK; };
+    env.fns->PopLocalFrame = [] (JNIEnv*, jobject) -> jobject { return nullptr; };
+
+    jni::ReferenceStatistics::SetLeakHandler(OnLeak);
+
+       {
+        jni::ReferenceTracking::Site site("locals");
+        auto a = jni::NewLocalRef(env, objectValue.Ptr());
+        auto b = jni::NewLocalRef(env, objectValue.Ptr());
+        auto c = jni::NewLocalRef(env, objectValue.Ptr());
+
+        auto report = jni::ReferenceStatistics::Snapshot();
+        assert(Counts(report, jni::ReferenceKind::Local).live == 3);
+
+        const jni::ReferenceSiteStatistics* locals = Find(report, jni::JNIFunction::NewLocalRef, "locals");
+        assert(locals);
+        assert(locals->kind == jni::ReferenceKind::Local);
+        assert(locals->counts.live == 3);
+       }
+
+    auto report = jni::ReferenceStatistics::Snapshot();
+    assert(Counts(report, jni::ReferenceKind::Local).live == 0);
+    assert(Counts(report, jni::ReferenceKind::Local).highWater == 3);
+    assert(Counts(report, jni::ReferenceKind::Local).leaked == 0);
+
+    // A local reference that outlives its frame is counted as leaked when the frame is popped.
+       {
+        auto frame = jni::PushLocalFrame(env, 2);
+        auto kept = jni::NewLocalRef(env, objectValue.Ptr());
+        jni::NewLocalRef(env, objectValue.Ptr()).release();
+        kept.reset();
+       }
+
+    assert(leaked == 1);
+    report = jni::ReferenceStatistics::Snapshot();
+    assert(Counts(report, jni::ReferenceKind::Local).live == 0);
+    assert(Counts(report, jni::ReferenceKind::Local).leaked == 1);
+    assert(Find(report, jni::JNIFunction::NewLocalRef, "")->counts.leaked == 1);
+
+    // As is one still live when its thread exits.
+    std::thread([] { jni::NewLocalRef(env, objectValue.Ptr()).release(); }).join();
+
+    assert(leaked == 2);
+    report = jni::ReferenceStatistics::Snapshot();
+    assert(Counts(report, jni::ReferenceKind::Local).leaked == 2);
+    assert(Counts(report, jni::ReferenceKind::Local).created == 6);
+
+       {
+        auto global = jni::NewGlobalRef(env, objectValue.Ptr());
+        assert(Counts(jni::ReferenceStatistics::Snapshot(), jni::ReferenceKind::Global).live == 1);
+       }
+
+    report = jni::ReferenceStatistics::Snapshot();
+    assert(Counts(report, jni::ReferenceKind::Global).live == 0);
+    assert(Counts(report, jni::ReferenceKind::Global).highWater == 1);
+    assert(Counts(report, jni::ReferenceKind::Global).leaked == 0);
+
+    std::ostringstream json;
+    jni::WriteJSON(json, report);
+    assert(json.str().find("\"Local\":{\"created\":6,\"live\":0,\"highWater\":3,\"leaked\":2}") != std::string::npos);
+    assert(json.str().find("{\"kind\":\"Local\",\"function\":\"NewLocalRef\",\"site\":\"locals\"") != std::string::npos);
+
+    // Local references still live when a native method returns are released by the JVM: they are
+    // neither leaked nor accumulated across calls.
+    auto method = jni::MakeNativeMethod("method", "()V", [] (JNIEnv* e, jni::jobject*)
+       {
+        jni::NewLocalRef(*e, objectValue.Ptr()).release();
+        jni::NewLocalRef(*e, objectValue.Ptr()).release();
+       });
+
+    auto noexceptMethod = jni::MakeNativeMethod("noexceptMethod", "()V", [] (JNIEnv* e, jni::jobject*) noexcept
+       {
+        jni::NewLocalRef(*e, objectValue.Ptr()).release();
+        jni::NewLocalRef(*e, objectValue.Ptr()).release();
+       });
+
+    method.fnPtr(&env, objectValue.Ptr());
+    method.fnPtr(&env, objectValue.Ptr());
+    noexceptMethod.fnPtr(&env, objectValue.Ptr());
+
+    report = jni::ReferenceStatistics::Snapshot();
+    assert(Counts(report, jni::ReferenceKind::Local).created == 12);
+    assert(Counts(report, jni::ReferenceKind::Local).live == 0);
+    assert(Counts(report, jni::ReferenceKind::Local).highWater == 3);
+    assert(Counts(report, jni::ReferenceKind::Local).leaked == 2);
+    assert(leaked == 2);
+
+    // Nor are those left in the frames that the library uses to batch the elements of an array.
+    static JNIInvokeInterface vmFunctions {};
+    static JavaVM vm { &vmFunctions };
+    static Testable<jni::jclass> classValue;
+    static Testable<jni::jmethodID> methodValue;
+    static Testable<jni::jfieldID> fieldValue;
+    static Testable<jni::jarray<jni::jobject>> arrayValue;
+
+    vmFunctions.GetEnv = [] (JavaVM*, void**, jint) -> jint { return JNI_EDETACHED; };
+    env.fns->GetJavaVM = [] (JNIEnv*, JavaVM** result) -> jint { *result = &vm; return JNI_OK; };
+    env.fns->FindClass = [] (JNIEnv*, const char*) -> jclass { return jni::Unwrap(classValue.Ptr()); };
+    env.fns->GetMethodID = [] (JNIEnv*, jclass, const char*, const char*) -> jmethodID { return jni::Unwrap(methodValue.Ptr()); };
+    env.fns->GetFieldID = [] (JNIEnv*, jclass, const char*, const char*) -> jfieldID { return jni::Unwrap(fieldValue.Ptr()); };
+    env.fns->GetIntField = [] (JNIEnv*, jobject, jfieldID) -> jint { return 7; };
+    env.fns->CallObjectMethodV = [] (JNIEnv*, jobject, jmethodID, va_list) -> jobject { return jni::Unwrap(arrayValue.Ptr()); };
+    env.fns->GetArrayLength = [] (JNIEnv*, jarray) -> jsize { return 5; };
+    env.fns->GetObjectArrayElement = [] (JNIEnv*, jobjectArray, jsize i) -> jobject { return jni::Unwrap(objects[i].Ptr()); };
+
+    jni::Local<jni::Array<jni::Integer>> array { env, arrayValue.Ptr() };
+
+    std::size_t visited = 0;
+    jni::ForEachElement(env, array, [&] (const jni::Integer&) { ++visited; });
+    assert(visited == 5);
+
+    assert(jni::Unbox(env, array) == std::vector<jni::jint>(5, 7));
+
+    jni::Local<jni::List<jni::Integer>> list { env, objectValue.Ptr() };
+    assert(jni::Make<std::vector<jni::jint>>(env, list) == std::vector<jni::jint>(5, 7));
+
+    report = jni::ReferenceStatistics::Snapshot();
+    assert(Counts(report, jni::ReferenceKind::Local).live == 0);
+    assert(Counts(report, jni::ReferenceKind::Local).leaked == 2);
+    assert(leaked == 2);
+
+    return 0;
+   }
@@ -2,6 +2,7 @@
 
 #ifdef _JAVASOFT_JNI_H_
 using JNINativeInterface = JNINativeInterface_;
+using JNIInvokeInterface = JNIInvokeInterface_;
 #endif
 
 template < class T >
@@ -0,0 +1,98 @@
+#include "test.hpp"
+
+#include <jni/tracing.hpp>
+
+namespace jni
+   {
+    template <> struct TracingPolicy<> { using Type = NativeMethodTracer; };
+   }
+
+#include <jni/jni.hpp>
+
+#include <cassert>
+#include <sstream>
+#include <thread>
+
+struct Test { static constexpr auto Name() { return "Test"; } };
+
+static void LowLevel(JNIEnv*, jni::jobject*) {}
+
+static std::size_t Count(const std::vector<jni::NativeTraceEvent>& events, const std::string& name)
+   {
+    std::size_t count = 0;
+    for (const auto& e : events)
+        if (e.name == name)
+            ++count;
+    return count;
+   }
+
+int main()
+   {
+    static_assert(std::is_same<jni::Tracing, jni::NativeMethodTracer>::value, "");
+
+    static TestEnv env;
+
+    auto add = jni::MakeNativeMethod("add", [] (JNIEnv&, jni::Object<Test>&, jni::jint a, jni::jint b) { return a + b; });
+    auto noexceptMethod = jni::MakeNativeMethod("noexceptMethod", [] (JNIEnv&, jni::Object<Test>&) noexcept {});
+    auto lowLevel = jni::MakeNativeMethod<decltype(&LowLevel), &LowLevel>("lowLevel", "()V");
+
+    auto callAdd = [&] { return reinterpret_cast<jint (*)(JNIEnv*, jobject, jint, jint)>(add.fnPtr)(&env, nullptr, 1, 2); };
+
+    assert(callAdd() == 3);
+    reinterpret_cast<void (*)(JNIEnv*, jobject)>(noexceptMethod.fnPtr)(&env, nullptr);
+    reinterpret_cast<void (*)(JNIEnv*, jobject)>(lowLevel.fnPtr)(&env, nullptr);
+
+    auto events = jni::NativeMethodTracer::Events();
+    assert(events.size() == 3);
+    assert(Count(events, "add") == 1);
+    assert(Count(events, "noexceptMethod") == 1);
+    assert(Count(events, "lowLevel") == 1);
+    for (const auto& e : events)
+       {
+        assert(e.end >= e.begin);
+        assert(e.thread == events[0].thread);
+       }
+
+    // The name is fixed by the first registration of a given method: a second registration of
+    // the same function is traced under the first name.
+    jni::NativeMethodTracer::Clear();
+    auto alias = jni::MakeNativeMethod<decltype(&LowLevel), &LowLevel>("alias", "()V");
+    reinterpret_cast<void (*)(JNIEnv*, jobject)>(alias.fnPtr)(&env, nullptr);
+    assert(alias.name == std::string("alias"));
+    events = jni::NativeMethodTracer::Events();
+    assert(events.size() == 1);
+    assert(Count(events, "lowLevel") == 1);
+
+    // Sampling records one call in every `interval` on each thread.
+    jni::NativeMethodTracer::Clear();
+    jni::NativeMethodTracer::SetSamplingInterval(3);
+    for (int i = 0; i < 9; ++i)
+        callAdd();
+    assert(jni::NativeMethodTracer::Events().size() == 3);
+
+    jni::NativeMethodTracer::SetSamplingInterval(0);
+    callAdd();
+    assert(jni::NativeMethodTracer::Events().size() == 3);
+
+    // Each thread's ring buffer keeps only its most recent events, and they outlive the thread.
+    jni::NativeMethodTracer::Clear();
+    jni::NativeMethodTracer::SetSamplingInterval(1);
+    jni::NativeMethodTracer::SetBufferCapacity(4);
+    std::thread([&] {
+        for (int i = 0; i < 10; ++i)
+            callAdd();
+    }).join();
+
+    events = jni::NativeMethodTracer::Events();
+    assert(events.size() == 4);
+    assert(events[0].thread != 1);
+    for (std::size_t i = 1; i < events.size(); ++i)
+        assert(events[i].begin >= events[i - 1].begin);
+
+    std::ostringstream json;
+    jni::WriteChromeTrace(json, events);
+    assert(json.str().find("{\"traceEvents\":[") == 0);
+    assert(json.str().find("{\"name\":\"add\",\"cat\":\"jni\",\"ph\":\"X\",\"ts\":") != std::string::npos);
+
+    return 0;
+   }